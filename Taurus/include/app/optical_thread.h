@@ -1,15 +1,30 @@
 #pragma once
 
 #include <thread>
+#include <barrier>
+#include <memory>
 
 #include "core/tracking/tracking_utils.h"
 #include "core/tracking/detector.h"
+#include "core/tracking/roi_prediction.h"
+#include "core/tracking/multiview.h"
+#include "core/tracking/correspondence.h"
+#include "core/tracking/static_lights.h"
+#include "core/tracking/blink_code.h"
 #include "core/cameras.h"
 #include "core/config.h"
 #include "core/psmove.h"
 
 namespace taurus
 {
+	class OpticalThread;
+
+	// runs once every camera worker has finished its frame, while all of them are waiting
+	struct TriangulationCompletion {
+		OpticalThread* opticalThread;
+		void operator()() noexcept;
+	};
+
 	class OpticalThread
 	{
 		public:
@@ -24,23 +39,63 @@ namespace taurus
 			std::vector<tracking::TrackedObject*>* GetTrackedObjects();
 		private:
 			static OpticalThread* instance;
+			friend struct TriangulationCompletion;
 
-			void ThreadFunc();
+			void CameraWorkerFunc(int cameraIndex);
+			void TriangulateGeneration();
+			void FinishStaticLightLearning();
+			// controllers sharing a color blink their codes for a moment, then every one of them takes the ball that carried its code
+			void StartIdentification();
+			void FinishIdentification();
+			// from the view with the largest ball, when the views couldn't be triangulated
+			bool EstimateMonocularPosition(tracking::TrackedObject* obj, const tracking::TriangulationPoint& point);
+			void PredictRois(float secPassed);
 
 			TaurusConfig* config;
 			ControllerManager* controllers;
 			CameraManager* cameraManager;
 
 			std::vector<tracking::TrackedObject*> trackedObjects;
-			int fps = 0;
+			std::atomic<int> fps = 0;
 
 			std::vector<std::string> connectedControllers;
 			size_t cameraCount;
-			CameraCalibration calib0;
-			CameraCalibration calib1;
-			cv::Mat frame;
+			std::vector<CameraCalibration> calibrations;
+			std::vector<tracking::TriangulationCamera> triangulationCameras;
+			std::vector<const tracking::UndistortionGrid*> undistortionGrids;
+			tracking::EpipolarGeometry epipolarGeometry;
+			// tracked objects whose controllers have the same color, only groups of two or more
+			std::vector<std::vector<tracking::TrackedObject*>> sameColorGroups;
+			std::vector<tracking::CameraProjection> projections;
+
+			// only used by the completion step, one triangulation point per tracked object
+			std::vector<tracking::ViewObservation> triangulationViews;
+			std::vector<tracking::TriangulationPoint> triangulationPoints;
+
+			// one detection worker and frame ring cursor per camera, timestamps are the cameras' capture times in us
+			std::vector<cv::Size> frameSizes;
+			std::vector<FrameCursor> frameCursors;
+			std::vector<int64_t> frameTimestamps;
+			std::vector<tracking::RowTiming> rowTimings;
+			std::vector<std::thread> cameraThreads;
+
+			// joins the workers after every frame generation, the completion step triangulates
+			std::unique_ptr<std::barrier<TriangulationCompletion>> generationBarrier;
+			uint64_t generation = 0;
+			int64_t lastGenerationTimestamp = 0;
+
+			// static lights of every camera, each worker learns and updates its own camera's mask
+			std::vector<tracking::StaticLightMask> staticLights;
+
+			// brightness of every tracked object's ball while the controllers blink, per camera, each worker samples its own camera
+			std::vector<std::vector<tracking::BlinkDecoder>> blinkDecoders;
 
-			std::thread thread;
+			// only written by the completion step, so every worker sees the same value after the barrier
+			bool generationActive = false;
+			bool learnStaticLights = false;  // the first generations learn the static lights instead of tracking
+			int staticLightFrames = 0;
+			bool identifyControllers = false;  // the same colored controllers still have to be identified by their blink codes
+			int64_t identificationStartUs = 0;  // capture time the blink codes are sampled from
 			std::atomic<bool> threadActive = false;
 	};
 }
@@ -10,6 +10,9 @@
 #include "core/logging.h"
 #include "core/utils.h"
 #include "core/cameras.h"
+#include "core/synthetic_source.h"
+#include "core/session_recorder.h"
+#include "core/session_replayer.h"
 #include "core/psmove.h"
 #include "core/config.h"
 
@@ -41,6 +44,9 @@ namespace taurus
 			CameraManager* cameraManager;
 			size_t cameraCount;
 			cv::Mat frame;
+
+			SessionRecorder* sessionRecorder;
+			SessionReplayer* sessionReplayer;
 			
 			CommunicationThread* commsThread;
 			FilterThread* filterThread;
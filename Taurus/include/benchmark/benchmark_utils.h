@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+
+namespace taurus::benchmark
+{
+	// runs fn the given amount of times and returns the average time of a single run in nanoseconds
+	template<typename F>
+	double measureAverageNs(int iterations, F&& fn) {
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			fn(i);
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		double totalNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+		return totalNs / static_cast<double>(iterations);
+	}
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace taurus::benchmark
+{
+	// renders glowing balls at known subpixel centers and compares the center estimators (and the old contour circle) for speed and accuracy
+	void runCenterBenchmark(int iterations = 200);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace taurus::benchmark
+{
+	// runs the detection and triangulation on synthetic cameras rendering scripted controllers, no hardware needed
+	// measures the detection time per frame against the frame period, the detection rate and the 2D/3D error to the ground truth
+	// with bayer set, the cameras deliver raw mosaics and the detector demosaics only around the balls
+	void runPipelineBenchmark(int cameraCount = 2, int ballCount = 2, int frameCount = 600, int fps = 60, bool bayer = false);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace taurus::benchmark
+{
+	// compares the old maskBrightBlobs + cvtColor + inRange chain against the fused segmentation kernel on synthetic frames
+	void runSegmentationBenchmark(int iterations = 500);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace taurus::benchmark
+{
+	// compares the old cv::triangulatePoints path against the batched triangulation kernel on a synthetic rig, for speed and 3D error
+	void runTriangulationBenchmark(int iterations = 2000);
+}
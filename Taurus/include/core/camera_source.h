@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <ps3eye.h>
+
+#include "core/tracking/bayer.h"
+
+namespace taurus
+{
+	enum ExposureMode {
+		Exposure_AUTO,
+		Exposure_DARK
+	};
+
+	enum FrameFormat {
+		Frame_BGR,  // 3 bytes per pixel
+		Frame_BAYER  // the raw sensor mosaic, 1 byte per pixel
+	};
+
+	// where a Camera gets its frames from, real hardware or a renderer
+	// only the camera's capture thread grabs frames, the settings may be changed from any thread
+	class CameraSource {
+		public:
+			virtual ~CameraSource() = default;
+
+			virtual const char* GetName() const = 0;
+
+			virtual void Start(int width, int height, uint16_t fps) = 0;
+			virtual void Stop() = 0;
+
+			// actual frame size, may differ from the requested one
+			virtual int GetWidth() const = 0;
+			virtual int GetHeight() const = 0;
+
+			virtual void SetExposureMode(ExposureMode mode) = 0;
+
+			// has to be set before starting, returns false if the source can't deliver that format (it keeps its current one then)
+			virtual bool SetFrameFormat(FrameFormat format) { return format == Frame_BGR; }
+			virtual FrameFormat GetFrameFormat() const { return Frame_BGR; }
+			virtual tracking::BayerPattern GetBayerPattern() const { return tracking::PS3EYE_BAYER_PATTERN; }
+
+			// rolling shutter sensors read their rows one after another, this is the time between two rows
+			// 0 for sources that capture the whole frame at once (or can't tell)
+			virtual int64_t GetRowReadoutNs() const { return 0; }
+
+			// the capture waits for the tracking to release every frame before grabbing the next one (see FrameRing::SetBlocking)
+			// for sources that would otherwise produce frames as fast as they can
+			virtual bool IsConsumerPaced() const { return false; }
+
+			// blocks until the next frame is written into data (GetWidth() * GetHeight() pixels in the source's frame format)
+			// the timestamp is the frame's capture time on the captureClockUs clock, for a rolling shutter the readout of its last row
+			virtual void GrabFrame(uint8_t* data, int64_t& timestampUs) = 0;
+	};
+
+	class PS3EyeSource : public CameraSource {
+		public:
+			PS3EyeSource(ps3eye::PS3EYECam::PS3EYERef ps3eyeRef);
+
+			const char* GetName() const override;
+
+			void Start(int width, int height, uint16_t fps) override;
+			void Stop() override;
+
+			int GetWidth() const override;
+			int GetHeight() const override;
+
+			void SetExposureMode(ExposureMode mode) override;
+
+			// the driver can hand out the raw mosaic, which skips its full frame conversion
+			bool SetFrameFormat(FrameFormat format) override;
+			FrameFormat GetFrameFormat() const override;
+
+			// from the sensor's rows per frame (active and blanking) and the configured frame rate
+			int64_t GetRowReadoutNs() const override;
+
+			void GrabFrame(uint8_t* data, int64_t& timestampUs) override;
+
+		private:
+			ps3eye::PS3EYECam::PS3EYERef ps3eyeRef;
+			FrameFormat frameFormat = Frame_BGR;
+	};
+}
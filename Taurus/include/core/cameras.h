@@ -1,16 +1,23 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <opencv2/opencv.hpp>
 #include <ps3eye.h>
 
+#include "core/camera_source.h"
+#include "core/frame_ring.h"
 #include "core/tracking/tracking_utils.h"
+#include "core/tracking/color_lut.h"
+#include "core/tracking/subpixel.h"
+#include "core/tracking/time_alignment.h"
+#include "core/tracking/undistortion.h"
 
 namespace taurus
 {
-	enum ExposureMode {
-		Exposure_AUTO,
-		Exposure_DARK
-	};
+	class SyntheticScene;
+	class SessionReplayer;
 
 	struct CameraCalibration {
 		bool hasColor = false;
@@ -30,32 +37,80 @@ namespace taurus
 
 	class Camera {
 		public:
-			Camera(uint8_t id, ps3eye::PS3EYECam::PS3EYERef ps3eyeRef, int width = 640, int height = 480, uint16_t fps = 60, ExposureMode exposureMode = Exposure_AUTO);
+			// raw bayer frames are only requested, sources that can't deliver them fall back to BGR
+			Camera(uint8_t id, std::unique_ptr<CameraSource> source, int width = 640, int height = 480, uint16_t fps = 60, ExposureMode exposureMode = Exposure_AUTO, FrameFormat frameFormat = Frame_BGR);
+			Camera(const Camera&) = delete;
+			Camera& operator=(const Camera&) = delete;
+			~Camera();
 
 			void LoadData();
+			// replaces the loaded calibration, for cameras whose calibration doesn't come from files
+			void SetCalibration(const CameraCalibration& calibration);
+			const char* GetSourceName() const;
 
 			void SetExposureMode(ExposureMode mode);
+			// format of the frames in the ring, the detector reads both, everything else should use GetFrame
+			FrameFormat GetFrameFormat() const;
+			tracking::BayerPattern GetBayerPattern() const;
+			// when the sensor read each row, relative to the frame timestamps
+			tracking::RowTiming GetRowTiming() const;
 			uint8_t GetID() const;
 			bool IsStarted() const;
 			tracking::HsvColorRange GetHsvColorRange(std::string color);
 			CameraCalibration GetCalibration() const;
-
+			// rebuilt with the intrinsic calibration, not built without one
+			const tracking::UndistortionGrid& GetUndistortionGrid() const;
+
+			// colors of the tracked controllers, in controller order, the color lookup table is built for these
+			void SetTrackedColors(const std::vector<std::string>& colorNames);
+			const tracking::ColorLut& GetColorLut() const;
+
+			void SetCenterEstimator(tracking::CenterEstimator estimator);
+			tracking::CenterEstimator GetCenterEstimator() const;
+
+			// every camera captures on its own thread into a frame ring, any amount of consumers can read from it
+			// the camera manager starts capturing once every camera is set up
+			void StartCapture();
+			// waits for a frame newer than the cursor's, the view is zero-copy and holds the frame until it's released
+			bool WaitFrame(FrameCursor& cursor, FrameView& view);
+			// newest captured frame without waiting
+			bool GetLatestFrame(FrameView& view);
+			// frames the capture thread had to drop because every buffer was held by a view
+			uint64_t GetOverrunCount() const;
+
+			// copies the next new frame into the given mat as BGR (demosaiced if needed), for the preview and calibration
 			void GetFrame(cv::Mat& frame);
 			cv::Mat InitFrameMat();
 
 			void Stop();
 
 		private:
-			ps3eye::PS3EYECam::PS3EYERef ps3eyeRef;
+			std::unique_ptr<CameraSource> source;
 			uint8_t id;
-			bool isStarted;
+			bool isStarted = false;
 
 			int width;
 			int height;
 			uint16_t fps;
 			ExposureMode exposureMode;
+			FrameFormat frameFormat;
 
 			CameraCalibration calibration;
+			tracking::UndistortionGrid undistortionGrid;
+			void RebuildUndistortionGrid();
+
+			std::vector<std::string> trackedColors;
+			tracking::ColorLut colorLut;
+			void RebuildColorLut();
+
+			tracking::CenterEstimator centerEstimator = tracking::Center_CIRCLE_FIT;
+
+			void CaptureThreadFunc();
+
+			std::unique_ptr<FrameRing> frameRing;
+			std::thread captureThread;
+			std::atomic<bool> captureActive = false;
+			FrameCursor copyCursor;
 	};
 
 	class CameraManager {
@@ -64,7 +119,13 @@ namespace taurus
 
 			CameraManager();
 
-			void SetupCameras(int width = 640, int height = 480, uint16_t fps = 60, taurus::ExposureMode exposureMode = taurus::ExposureMode::Exposure_AUTO);
+			void SetupCameras(int width = 640, int height = 480, uint16_t fps = 60, taurus::ExposureMode exposureMode = taurus::ExposureMode::Exposure_AUTO, taurus::FrameFormat frameFormat = taurus::Frame_BGR);
+			// virtual cameras rendering the scene, no hardware needed, the scene's balls and stage have to be set up already
+			// uses the calibration files where they exist, whatever is missing gets generated
+			void SetupSyntheticCameras(std::shared_ptr<SyntheticScene> scene, int cameraCount, int width = 640, int height = 480, taurus::ExposureMode exposureMode = taurus::ExposureMode::Exposure_AUTO, taurus::FrameFormat frameFormat = taurus::Frame_BGR);
+
+			// one camera per camera in the replayed session, the replayer has to be started already
+			void SetupReplayCameras(SessionReplayer* replayer);
 
 			size_t GetCameraCount() const;
 			Camera& GetCamera(uint8_t id);
@@ -75,7 +136,7 @@ namespace taurus
 		private:
 			static CameraManager* instance;
 
-			std::vector<Camera> cameras;
+			std::vector<std::unique_ptr<Camera>> cameras;
 
 			std::vector<ps3eye::PS3EYECam::PS3EYERef> ps3eyeReferences;
 			size_t ps3eyeCount;
@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 #include <filesystem>
 
 #include <glm/glm.hpp>
@@ -26,6 +27,19 @@ namespace taurus
 
 		std::optional<float> lowpassAlpha;
 		std::optional<float> lowpassDistance;
+
+		std::optional<std::vector<std::string>> centerEstimators;
+
+		std::optional<std::string> cameraSource;
+		std::optional<int> syntheticCameraCount;
+		std::optional<bool> bayerDetection;
+		std::optional<bool> staticLightSuppression;
+		std::optional<bool> blinkIdentification;
+
+		std::optional<std::string> recordSession;
+		std::optional<bool> recordFrames;
+		std::optional<std::string> replaySession;
+		std::optional<bool> replayRealtime;
 	};
 
 	class TaurusConfig {
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+namespace taurus
+{
+	class FrameRing;
+
+	// monotonic clock the capture timestamps are taken with, in microseconds
+	int64_t captureClockUs();
+
+	// read-only, zero-copy view of a captured frame
+	// the frame can't be overwritten while the view holds it, so views should be released as soon as the frame isn't needed anymore
+	class FrameView {
+		public:
+			FrameView() = default;
+			FrameView(const FrameView&) = delete;
+			FrameView& operator=(const FrameView&) = delete;
+			FrameView(FrameView&& other) noexcept;
+			FrameView& operator=(FrameView&& other) noexcept;
+			~FrameView();
+
+			void Release();
+			bool IsValid() const;
+
+			// shares the ring's pixel data, must not be written to
+			cv::Mat frame;
+			uint64_t sequence = 0;
+			int64_t timestampUs = 0;
+
+		private:
+			friend class FrameRing;
+
+			FrameRing* ring = nullptr;
+			int slot = -1;
+			bool consumes = false;  // releasing it lets a blocking ring's producer go on
+	};
+
+	// per consumer read position, every consumer gets every new frame (or knows how many it missed)
+	struct FrameCursor {
+		uint64_t lastSequence = 0;
+		uint64_t droppedFrames = 0;
+		// in a blocking ring, the producer waits for this reader to release every frame (at most one such reader per ring)
+		bool pacesProducer = false;
+	};
+
+	// lock-free single producer ring of preallocated frames, the newest frame is always available to any amount of readers
+	// the producer never waits for readers, it writes into any slot that isn't pinned by a view or holding the newest frame
+	// unless the ring is blocking, then it waits until the pacing reader released the newest frame, so that reader sees every frame
+	// (for sources that would otherwise produce as fast as they can, like a replay that isn't realtime)
+	class FrameRing {
+		public:
+			static constexpr int SLOT_COUNT = 4;
+
+			FrameRing(int width, int height, int type);
+			FrameRing(const FrameRing&) = delete;
+			FrameRing& operator=(const FrameRing&) = delete;
+
+			// has to be set before the first frame is written
+			void SetBlocking(bool blocking);
+
+			// producer side, BeginWrite always returns a buffer, if every slot is pinned the frame goes to a scratch buffer and is dropped
+			cv::Mat& BeginWrite();
+			void EndWrite(int64_t timestampUs);
+
+			// blocks until a frame newer than the cursor's is published, returns false once the ring is closed
+			bool WaitNext(FrameCursor& cursor, FrameView& view);
+			// newest frame without waiting, returns false if nothing was captured yet
+			bool TryGetLatest(FrameView& view);
+
+			// wakes every waiting reader, WaitNext returns false from now on
+			void Close();
+			bool IsClosed() const;
+
+			uint64_t GetSequence() const;
+			// frames the producer had to drop because every slot was pinned
+			uint64_t GetOverrunCount() const;
+
+		private:
+			friend class FrameView;
+
+			// pins is -1 while the producer writes the slot, otherwise the amount of views holding it
+			struct Slot {
+				cv::Mat frame;
+				std::atomic<int> pins = 0;
+				uint64_t sequence = 0;
+				int64_t timestampUs = 0;
+			};
+
+			bool Pin(int slot, FrameView& view);
+			void Unpin(int slot);
+			void Consume(uint64_t sequence);
+
+			static constexpr uint64_t SLOT_BITS = 8;
+			static constexpr uint64_t SLOT_MASK = (uint64_t(1) << SLOT_BITS) - 1;
+			static constexpr uint64_t NO_SLOT = SLOT_MASK;
+
+			std::array<Slot, SLOT_COUNT> slots;
+			cv::Mat scratch;
+
+			// (sequence << SLOT_BITS) | slot of the newest frame, readers wait on it
+			std::atomic<uint64_t> published = NO_SLOT;
+			std::atomic<bool> closed = false;
+			std::atomic<uint64_t> overruns = 0;
+
+			// blocking mode, the newest sequence the pacing reader released
+			bool blocking = false;
+			std::atomic<uint64_t> consumed = 0;
+
+			// producer only
+			int writeSlot = -1;
+			uint64_t nextSequence = 1;
+			uint64_t lastPublished = 0;
+	};
+}
@@ -33,6 +33,19 @@ namespace taurus
 		int elapsedTimeMs;
 	};
 
+	// everything a single poll reads from the controller, recorded sessions are replayed from these
+	struct ControllerSample {
+		int64_t timeMs = 0;
+		uint32_t buttons = 0;
+		uint32_t trigger = 0;
+		int32_t battery = 0;  // PSMove_Battery_Level
+		int32_t reserved = 0;
+
+		// raw accelerometer and gyroscope readings of both sensor half-frames
+		glm::vec3 accel[2] = {};
+		glm::vec3 gyro[2] = {};
+	};
+
 	struct ImuCalibration {
 		bool hasGyro;
 		glm::vec3 gyroOffsets;
@@ -51,6 +64,10 @@ namespace taurus
 			void LoadData();
 
 			void Connect(PSMove* move);
+			// marks the controller connected without a device, its samples come from a recorded session
+			void ConnectReplay();
+			// runs a recorded sample through the same handlers a poll goes through
+			void ReplaySample(const ControllerSample& sample);
 			bool Update();  // returns if poll successful (new data)
 			void Disconnect();
 
@@ -60,6 +77,9 @@ namespace taurus
 			void SetColor(std::string_view colorName);
 			void SetColorRaw(RGB_char color);
 			std::string GetColorName();
+			// modulates the LED brightness with a blink code (see tracking::blinkCode), until it's cleared
+			void SetBlinkCode(uint8_t code);
+			void ClearBlinkCode();
 
 			void DoRumble(float durationSeconds, float strength);
 
@@ -82,9 +102,11 @@ namespace taurus
 
 		private:
 			void HandlePoll();
-			void HandleBattery(long now);
-			void HandleInput(long now);
-			void HandleAhrs(long now);
+			void ReadSample(ControllerSample& sample);
+			void ProcessSample(const ControllerSample& sample);
+			void HandleBattery(const ControllerSample& sample);
+			void HandleInput(const ControllerSample& sample);
+			void HandleAhrs(const ControllerSample& sample);
 
 			void HandleRumble(long now);
 
@@ -104,6 +126,8 @@ namespace taurus
 			std::string colorName;
 			RGB_char color;
 			bool colorDirty;
+			std::atomic<int> blinkCode = -1;  // -1 without a code
+			long blinkStep = -1;  // the code step the LEDs show, only touched by the update thread
 
 			// haptics
 			RumbleState rumbleState;
@@ -148,6 +172,8 @@ namespace taurus
 			void StopUpdateThreads();
 
 			void ConnectControllers();
+			// connects device-less controllers for a session replay
+			void ConnectReplayControllers(const std::vector<std::string>& serials);
 			void UpdateControllers();
 			void DisconnectControllers();
 
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+namespace fs = std::filesystem;
+
+namespace taurus
+{
+	// recorded session file layout, everything little endian and 8 byte aligned:
+	// [file header] [record header + payload]... [index entries] [footer]
+	// the index and footer are written when the recording is stopped, a session that was cut short is still readable by scanning the records
+	constexpr char SESSION_MAGIC[8] = { 'T', 'A', 'U', 'R', 'S', 'E', 'S', 'S' };
+	constexpr char SESSION_INDEX_MAGIC[8] = { 'T', 'A', 'U', 'R', 'I', 'N', 'D', 'X' };
+	constexpr uint32_t SESSION_VERSION = 1;
+
+	enum SessionRecordType : uint32_t {
+		Record_CAMERA_FRAME = 1,  // stream is the camera id, payload is SessionFrameInfo and the pixels
+		Record_CONTROLLER_INFO = 2,  // stream is the controller's stream id, payload is the serial
+		Record_CONTROLLER_SAMPLE = 3,  // stream is the controller's stream id, payload is a ControllerSample
+		Record_MESSAGE = 4,  // payload is a serialized outgoing TaurusMessage
+	};
+
+	struct SessionFileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		int64_t startTimestampUs;  // captureClockUs clock
+	};
+
+	struct SessionRecordHeader {
+		uint32_t type;
+		uint32_t size;  // payload bytes, without the padding
+		uint32_t stream;
+		uint32_t sequence;  // per type and stream
+		int64_t timestampUs;  // captureClockUs clock
+	};
+
+	struct SessionFrameInfo {
+		int32_t width;
+		int32_t height;
+		int32_t type;
+		uint32_t step;
+	};
+
+	struct SessionIndexEntry {
+		uint64_t offset;  // of the record header, from the start of the file
+		uint32_t type;
+		uint32_t stream;
+		int64_t timestampUs;
+	};
+
+	struct SessionFooter {
+		char magic[8];
+		uint64_t indexOffset;
+		uint64_t indexCount;
+	};
+
+	static_assert(sizeof(SessionFileHeader) % 8 == 0 && sizeof(SessionRecordHeader) % 8 == 0 && sizeof(SessionIndexEntry) % 8 == 0);
+
+	// records are padded, so the next header (and every frame's pixels) stays 8 byte aligned
+	constexpr uint64_t sessionPaddedSize(uint64_t size) {
+		return (size + 7) & ~uint64_t(7);
+	}
+
+	// read-only, memory mapped recorded session
+	// payloads point straight into the mapping, they stay valid until the log is closed
+	class SessionLog {
+		public:
+			SessionLog() = default;
+			SessionLog(const SessionLog&) = delete;
+			SessionLog& operator=(const SessionLog&) = delete;
+			~SessionLog();
+
+			bool Open(const fs::path& path);
+			void Close();
+			bool IsOpen() const;
+
+			int64_t GetStartTimestampUs() const;
+			// every record, ordered like in the file (by the time they were written)
+			const std::vector<SessionIndexEntry>& GetIndex() const;
+
+			const SessionRecordHeader& GetRecord(const SessionIndexEntry& entry) const;
+			const uint8_t* GetPayload(const SessionIndexEntry& entry) const;
+
+			// zero-copy view of a recorded camera frame
+			cv::Mat GetFrame(const SessionIndexEntry& entry) const;
+			std::string GetString(const SessionIndexEntry& entry) const;
+
+		private:
+			bool ReadIndex();
+			bool ScanRecords();
+
+			const uint8_t* data = nullptr;
+			uint64_t size = 0;
+			std::vector<SessionIndexEntry> index;
+
+			// platform mapping handles
+			void* fileHandle = nullptr;
+			void* mappingHandle = nullptr;
+	};
+}
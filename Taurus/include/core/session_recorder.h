@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "core/session_log.h"
+#include "core/psmove.h"
+
+namespace taurus
+{
+	// records camera frames, controller samples and the sent messages into one session file, for replaying them later
+	// the record calls only copy the data into a queue, a writer thread does the file io
+	class SessionRecorder {
+		public:
+			static SessionRecorder* GetInstance();
+
+			SessionRecorder();
+
+			// frames are the bulk of a session, without them only the controllers and messages are recorded
+			bool Start(const fs::path& path, bool recordFrames = true);
+			// writes the remaining records and the index
+			// also has to be called after a failed write stopped the recording, to close the file
+			void Stop();
+			bool IsRecording() const;
+
+			void RecordFrame(uint8_t cameraId, int64_t timestampUs, const cv::Mat& frame);
+			void RecordControllerSample(const std::string& serial, const ControllerSample& sample);
+			void RecordMessage(const void* data, size_t size);
+
+			uint64_t GetDroppedRecordCount() const;
+
+		private:
+			static SessionRecorder* instance;
+
+			struct PendingRecord {
+				SessionRecordHeader header;
+				std::vector<uint8_t> payload;
+			};
+
+			void Push(SessionRecordType type, uint32_t stream, int64_t timestampUs, std::vector<uint8_t>&& payload);
+			void WriterThreadFunc();
+
+			std::atomic<bool> recording = false;
+			bool recordFrames = true;
+
+			std::ofstream file;
+			uint64_t fileOffset = 0;
+			std::vector<SessionIndexEntry> index;
+			std::thread writerThread;
+
+			// the writer can fall behind for a while (a slow disk), records are dropped once too much is queued
+			static constexpr size_t MAX_QUEUED_BYTES = 256 * 1024 * 1024;
+
+			std::mutex queueMutex;
+			std::condition_variable queueCondition;
+			std::deque<PendingRecord> queue;
+			size_t queuedBytes = 0;
+			bool stopWriter = false;
+			bool writeFailed = false;  // set by the writer thread, it stops recording then
+			std::atomic<uint64_t> droppedRecords = 0;
+
+			// sequence numbers per type and stream, and the stream id of every recorded controller
+			std::unordered_map<uint64_t, uint32_t> sequences;
+			std::unordered_map<std::string, uint32_t> controllerStreams;
+	};
+}
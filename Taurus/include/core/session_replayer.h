@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "core/camera_source.h"
+#include "core/session_log.h"
+#include "core/psmove.h"
+
+namespace taurus
+{
+	// plays a recorded session back through the same entry points the hardware uses, the camera sources and the controllers' sample handlers
+	// recorded times are rebased onto the replay start, so the threads see the same spacing between frames and samples as when recording
+	// in realtime mode every stream waits for its recorded time, otherwise the controller samples run as fast as they can
+	// and every camera waits for the optical thread to release its previous frame, so the tracking sees every recorded frame
+	// the recorded messages aren't replayed, they are what the pipeline is expected to send again
+	class SessionReplayer {
+		public:
+			static SessionReplayer* GetInstance();
+
+			SessionReplayer();
+			~SessionReplayer();
+
+			bool Open(const fs::path& path);
+			void SetRealtime(bool realtime);
+			bool IsRealtime() const;
+
+			std::vector<std::string> GetControllerSerials() const;
+			size_t GetCameraCount() const;
+			const std::vector<SessionIndexEntry>& GetCameraFrames(uint8_t cameraId) const;
+			const SessionLog& GetLog() const;
+
+			// starts the replay clock and feeds the recorded samples to the manager's controllers
+			// the replayed cameras have to be set up after this, so they share the clock
+			void Start(ControllerManager* controllerManager);
+			void Stop();
+			bool IsFinished() const;
+
+			// a recorded timestamp on the replay's captureClockUs timeline
+			int64_t ReplayTimeUs(int64_t recordedTimestampUs) const;
+			// sleeps until the recorded time comes around, returns right away when not replaying in realtime
+			void WaitUntil(int64_t recordedTimestampUs) const;
+
+		private:
+			static SessionReplayer* instance;
+
+			void ControllerThreadFunc(ControllerManager* controllerManager);
+
+			SessionLog log;
+			bool realtime = true;
+
+			std::vector<std::vector<SessionIndexEntry>> cameraFrames;
+			std::vector<std::string> controllerSerials;  // by stream id
+			std::vector<SessionIndexEntry> controllerSamples;
+
+			int64_t replayStartUs = 0;
+			std::atomic<bool> running = false;
+			std::atomic<bool> controllersFinished = false;
+			std::thread controllerThread;
+	};
+
+	// a camera that grabs the frames one camera recorded, once they run out the last frame is repeated at a slow rate
+	class ReplayCameraSource : public CameraSource {
+		public:
+			ReplayCameraSource(SessionReplayer* replayer, uint8_t cameraId);
+
+			const char* GetName() const override;
+
+			// the recorded size and frame rate are used, the requested ones are ignored
+			void Start(int width, int height, uint16_t fps) override;
+			void Stop() override;
+
+			int GetWidth() const override;
+			int GetHeight() const override;
+
+			// the exposure and the frame format are baked into the recording
+			void SetExposureMode(ExposureMode mode) override;
+			bool SetFrameFormat(FrameFormat format) override;
+			FrameFormat GetFrameFormat() const override;
+
+			void GrabFrame(uint8_t* data, int64_t& timestampUs) override;
+			// only when not replaying in realtime
+			bool IsConsumerPaced() const override;
+
+			bool IsFinished() const;
+
+		private:
+			SessionReplayer* replayer;
+			const std::vector<SessionIndexEntry>& frames;
+
+			int width = 0;
+			int height = 0;
+			FrameFormat frameFormat = Frame_BGR;
+
+			size_t nextFrame = 0;
+			std::atomic<bool> finished = false;
+	};
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <glm/glm.hpp>
+
+#include "core/camera_source.h"
+#include "core/cameras.h"
+#include "core/tracking/roi_prediction.h"
+
+namespace taurus
+{
+	// a glowing ball moving along a scripted lissajous path, relative to the scene's stage center (cm)
+	struct SyntheticBall {
+		std::string colorName;
+		cv::Scalar color;  // bgr, as the camera sees it
+
+		glm::vec3 offset = {};
+		glm::vec3 amplitude = {};
+		glm::vec3 frequency = {};  // Hz
+		glm::vec3 phase = {};  // radians
+
+		glm::vec3 PositionAt(double seconds) const;
+	};
+
+	// how a camera in dark exposure mode sees a controller led of this rgb color, a bit darker and less saturated
+	cv::Scalar syntheticLedColor(int r, int g, int b);
+
+	// the world every synthetic camera renders, and its ground truth
+	// every camera captures frame k at the same time, so frames of different cameras can be matched by their timestamps
+	// the balls and the stage have to be set up before the cameras start capturing
+	class SyntheticScene {
+		public:
+			SyntheticScene(uint16_t fps = 60);
+
+			void AddBall(const SyntheticBall& ball);
+			// adds a ball with a generated path, every ball gets a different one
+			void AddScriptedBall(const std::string& colorName, const cv::Scalar& color);
+			size_t GetBallCount() const;
+			const SyntheticBall& GetBall(size_t index) const;
+
+			void SetStageCenter(const glm::vec3& center);
+			glm::vec3 GetStageCenter() const;
+
+			// restarts the scene clock, frame 0 is captured now
+			void Restart();
+			uint16_t GetFps() const;
+			int64_t GetFrameTimeUs(uint64_t frameIndex) const;
+			// latest frame whose capture time has passed
+			uint64_t GetCurrentFrameIndex() const;
+
+			// ground truth world position of a ball at a capture time
+			glm::vec3 GetBallPosition(size_t ballIndex, int64_t timestampUs) const;
+
+		private:
+			std::vector<SyntheticBall> balls;
+			glm::vec3 stageCenter = {};
+
+			uint16_t fps;
+			int64_t startUs = 0;
+	};
+
+	// how a synthetic camera projects the world, distortion included, so the ground truth can be compared to detections
+	struct SyntheticView {
+		tracking::CameraProjection projection;
+		cv::Matx33d K = cv::Matx33d::eye();
+		cv::Vec<double, 5> distort = {};
+	};
+
+	SyntheticView createSyntheticView(const CameraCalibration& calibration, const cv::Mat& originWorld, const cv::Size& frameSize);
+	// distorted image position and radius (pixels) of a ball, returns false if it's behind the camera
+	bool projectSyntheticBall(const SyntheticView& view, const glm::vec3& worldPosition, cv::Point2f& center, float& radius);
+
+	// fills in whatever the loaded calibrations are missing, in the same frames the extrinsic calibrator writes (T relative to cam 0, world per camera)
+	// a fully calibrated rig is rendered as it is, otherwise the cameras are placed on an arc around the stage, keeping any real intrinsics
+	void completeSyntheticCalibrations(std::vector<CameraCalibration>& calibrations, const cv::Size& frameSize);
+	// a point in front of camera 0 every camera of the rig can see
+	glm::vec3 syntheticStageCenter(const std::vector<CameraCalibration>& calibrations);
+
+	// renders the scene from one camera's calibration, paced by the scene's frame clock
+	class SyntheticCameraSource : public CameraSource {
+		public:
+			SyntheticCameraSource(std::shared_ptr<SyntheticScene> scene, uint32_t seed);
+
+			const char* GetName() const override;
+
+			// the frame rate comes from the scene, so every synthetic camera stays in sync
+			void Start(int width, int height, uint16_t fps) override;
+			void Stop() override;
+
+			int GetWidth() const override;
+			int GetHeight() const override;
+
+			void SetExposureMode(ExposureMode mode) override;
+
+			// raw frames are mosaiced with the PS3 Eye's pattern
+			bool SetFrameFormat(FrameFormat format) override;
+			FrameFormat GetFrameFormat() const override;
+
+			void GrabFrame(uint8_t* data, int64_t& timestampUs) override;
+
+			// must be set before the camera starts capturing
+			void SetView(const SyntheticView& view);
+
+		private:
+			void Render(cv::Mat& frame, int64_t timestampUs);
+
+			std::shared_ptr<SyntheticScene> scene;
+			SyntheticView view;
+
+			int width = 0;
+			int height = 0;
+			std::atomic<ExposureMode> exposureMode = Exposure_DARK;
+			FrameFormat frameFormat = Frame_BGR;
+
+			// a few prerendered noise frames, rendering fresh noise every frame would cost more than the detection
+			std::vector<cv::Mat> backgrounds;
+			cv::RNG rng;
+
+			uint64_t frameIndex = 0;
+	};
+}
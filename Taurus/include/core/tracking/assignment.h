@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+
+namespace taurus::tracking
+{
+	// minimum cost assignment of rows to columns (Hungarian method), for the handful of balls and blobs a frame has
+	// costs are row major, a pair costing more than the gate is never assigned
+	// as many rows as possible get a column, then the total cost is minimized, rows left without one get -1
+	void solveGatedAssignment(const std::vector<float>& costs, int rows, int columns, float gate, std::vector<int>& rowToColumn);
+}
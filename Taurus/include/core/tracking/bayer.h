@@ -0,0 +1,36 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+namespace taurus::tracking
+{
+	// color filter layouts, named by the top left 2x2 block of the sensor, row by row
+	enum BayerPattern {
+		Bayer_BGGR,
+		Bayer_GBRG,
+		Bayer_GRBG,
+		Bayer_RGGB
+	};
+
+	// the PS3 Eye's OV7725 starts with a green/blue row, followed by a red/green one
+	constexpr BayerPattern PS3EYE_BAYER_PATTERN = Bayer_GBRG;
+
+	// cv::cvtColor code that turns a mosaic with this pattern into BGR
+	int bayerToBgrCode(BayerPattern pattern);
+
+	// bounding box (frame coordinates) of the raw mosaic samples inside roi that are at or above the threshold, empty if there are none
+	// a demosaiced pixel can't have a channel brighter than the raw samples around it, so everything outside the box (grown by a pixel) stays dark
+	// samples under the optional ignore mask (frame sized CV_8UC1, 255 or 0) count as dark
+	cv::Rect findBrightBayerBounds(const cv::Mat& bayer, const cv::Rect& roi, int threshold, const cv::Mat* ignore = nullptr);
+
+	// demosaics only the window, into the same place of the frame sized BGR image (allocated if needed), the rest of bgr is left alone
+	// a couple of extra mosaic pixels around the window are converted too, so the window's edges are interpolated like the rest of it
+	void demosaicWindow(const cv::Mat& bayer, const cv::Rect& window, BayerPattern pattern, cv::Mat& bgr);
+	void demosaicFrame(const cv::Mat& bayer, BayerPattern pattern, cv::Mat& bgr);
+
+	// half resolution BGR, every 2x2 cell becomes one pixel (greens averaged), no interpolation at all
+	void binBayer(const cv::Mat& bayer, BayerPattern pattern, cv::Mat& bgr);
+
+	// the inverse, samples one channel of every BGR pixel, for rendering and testing
+	void mosaicBgr(const cv::Mat& bgr, BayerPattern pattern, cv::Mat& bayer);
+}
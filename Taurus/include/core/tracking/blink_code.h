@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace taurus::tracking
+{
+	// controllers sharing a color are told apart by a short code in their LED brightness, one code bit per LED update
+	// the codes differ in every rotation, so a ball's brightness over a few code periods decodes without knowing where the code started
+	constexpr int BLINK_CODE_BITS = 6;
+	constexpr int BLINK_STEP_MS = 100;  // the controllers write their LEDs every 100 ms at most
+	constexpr float BLINK_DIM_LEVEL = 0.4f;  // LED scale of a 0 bit, the ball stays bright enough to be tracked
+
+	// amount of distinct codes, and the code of the index-th controller of a group (wraps around)
+	int blinkCodeCount();
+	uint8_t blinkCode(int index);
+	// LED scale of a code at a controller tick (ms), every controller steps at the same ticks
+	float blinkLevel(uint8_t code, int64_t ticksMs);
+
+	// mean brightness of a detected ball over its bounds, any 8-bit frame (raw bayer samples are fine too)
+	float ballIntensity(const cv::Mat& frame, const cv::Rect& bounds);
+
+	// the brightness of one ball over consecutive frames, matched against the codes
+	class BlinkDecoder {
+		public:
+			void Reset();
+			void AddSample(int64_t timestampUs, float intensity);
+
+			// time the samples cover, a code needs a bit more than one period of them to be matched
+			int64_t GetDurationUs() const;
+			// correlation (-1 to 1) of the samples with the code in the phase it fits best, 0 without enough samples
+			float Match(uint8_t code) const;
+
+		private:
+			struct Sample {
+				int64_t timestampUs;
+				float intensity;
+			};
+
+			std::vector<Sample> samples;
+	};
+}
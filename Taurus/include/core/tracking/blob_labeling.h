@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/segmentation.h"
+
+namespace taurus::tracking
+{
+	// statistics of a single 8-connected blob of bright pixels, in the coordinates of the labeled image
+	struct BlobStats {
+		int area = 0;
+		cv::Rect bounds = {};
+		cv::Point2f centroid = {};
+
+		// central second moments, normalized by the area
+		float mu20 = 0.f;
+		float mu11 = 0.f;
+		float mu02 = 0.f;
+
+		// amount of pixels in the blob that passed each color range
+		std::array<int, MAX_SEGMENT_COLORS> colorVotes = {};
+
+		// radius of a disk with the same area
+		float equivalentRadius() const;
+		// ratio of the major and minor axis of the blob's moment ellipse, 1 for a disk
+		float elongation() const;
+		// color range with the most votes, -1 if the blob has none
+		int dominantColor() const;
+	};
+
+	// labels the bright pixels (CLASS_BRIGHT_BIT) of a class image from classifyRoi in a single pass
+	// uses run-length encoding and union-find over the runs, blobs smaller than minArea are dropped
+	void labelBlobs(const cv::Mat& classes, std::vector<BlobStats>& blobs, int minArea = 1);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <array>
+#include <opencv2/opencv.hpp>
+
+namespace taurus::tracking
+{
+	// default brightness gate, same as the one used by maskBrightBlobs
+	constexpr int DEFAULT_BRIGHT_THRESHOLD = 30;
+
+	// the adaptive gate stays inbetween, below the floor sensor noise gets through, above the ceiling a ball's dim edge is lost
+	constexpr int MIN_BRIGHT_THRESHOLD = 16;
+	constexpr int MAX_BRIGHT_THRESHOLD = 128;
+
+	constexpr int BRIGHTNESS_HISTOGRAM_BINS = 64;
+
+	// running brightness histogram of an object's roi in one camera, and the gate it settled on
+	// the gate lets a few times the ball's area through, so the amount of candidate pixels (and the detection cost) stays about the same in bright and dim rooms
+	struct AdaptiveThreshold {
+		std::array<float, BRIGHTNESS_HISTOGRAM_BINS> histogram = {};  // fraction of the roi's pixels per bin, averaged over the frames
+		bool hasHistogram = false;
+		int threshold = DEFAULT_BRIGHT_THRESHOLD;
+	};
+
+	// adds the roi's pixels (subsampled, gray for BGR frames and the raw samples of bayer mosaics) to the running histogram and moves the gate
+	// ballRadius is the detected radius in pixels, the gate only adapts around found balls (a lost ball's roi could be anything)
+	void updateAdaptiveThreshold(const cv::Mat& frame, const cv::Rect& roi, float ballRadius, AdaptiveThreshold& state);
+}
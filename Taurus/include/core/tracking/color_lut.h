@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/tracking_utils.h"
+#include "core/tracking/segmentation.h"
+
+namespace taurus::tracking
+{
+	// amount of bits kept per BGR channel, 5 bits -> 32x32x32 bins
+	constexpr int COLOR_LUT_BITS = 5;
+	constexpr int COLOR_LUT_BINS = 1 << COLOR_LUT_BITS;
+	constexpr int COLOR_LUT_SIZE = COLOR_LUT_BINS * COLOR_LUT_BINS * COLOR_LUT_BINS;
+
+	// quantized BGR -> class bits table (same bit layout as classifyRoi), built from the color calibration
+	// bit k is set when the bin passes the k-th color range, so with one range per controller it maps straight to the controller index
+	// a bin with no bits set is background
+	class ColorLut {
+		public:
+			void Build(const std::vector<HsvColorRange>& colors, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
+			void Clear();
+
+			bool IsBuilt() const;
+			size_t GetColorCount() const;
+			// the gate baked into the table, bins darker than it are background
+			int GetBrightThreshold() const;
+			const uchar* Data() const;
+
+			static inline int Index(uchar b, uchar g, uchar r) {
+				constexpr int SHIFT = 8 - COLOR_LUT_BITS;
+				return ((b >> SHIFT) << (2 * COLOR_LUT_BITS)) | ((g >> SHIFT) << COLOR_LUT_BITS) | (r >> SHIFT);
+			}
+			uchar Lookup(uchar b, uchar g, uchar r) const;
+
+		private:
+			std::vector<uchar> table;
+			size_t colorCount = 0;
+			int brightThreshold = DEFAULT_BRIGHT_THRESHOLD;
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/tracking_utils.h"
+#include "core/tracking/multiview.h"
+#include "core/tracking/undistortion.h"
+
+namespace taurus::tracking
+{
+	// pixels a detection may be off the epipolar line of another camera's detection and still be the same ball
+	// covers the detection noise and the motion between the unsynchronized cameras' captures
+	constexpr float EPIPOLAR_GATE = 8.f;
+	// pixels a detection may be from where an object is predicted and still be assigned to it
+	constexpr float PREDICTION_GATE = 80.f;
+
+	// fundamental matrices between every pair of triangulation cameras, in the coordinates their views are given in
+	class EpipolarGeometry {
+		public:
+			void Build(const std::vector<TriangulationCamera>& cameras);
+
+			bool HasPair(int cameraA, int cameraB) const;
+			// distance of both views to the other one's epipolar line, averaged, in pixels
+			float Distance(const ViewObservation& a, const ViewObservation& b) const;
+
+		private:
+			int cameraCount = 0;
+			std::vector<cv::Matx33d> fundamentals;  // [b * cameraCount + a], x_b^T * F * x_a = 0
+			std::vector<bool> valid;
+			std::vector<double> pixelScales;
+	};
+
+	// re-pairs the detections of objects sharing a color, the color can't tell which of the balls is whose
+	// the group's detections are matched across the cameras into balls with the epipolar constraint, then the balls are assigned to the objects by their predicted positions
+	// both are gated assignments, a detection nothing matches is dropped, and an object without a ball loses tracking in those cameras
+	// the grids are the cameras' undistortion grids, in camera order
+	void matchSameColorObjects(const std::vector<TriangulationCamera>& cameras, const std::vector<const UndistortionGrid*>& grids, const EpipolarGeometry& epipolar, const std::vector<TrackedObject*>& group);
+}
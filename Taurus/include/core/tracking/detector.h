@@ -3,18 +3,41 @@
 #include <opencv2/opencv.hpp>
 
 #include "core/tracking/tracking_utils.h"
+#include "core/tracking/color_lut.h"
+#include "core/tracking/subpixel.h"
+#include "core/tracking/bayer.h"
 
 #define CONTOUR_T std::vector<cv::Point>
 #define CONTOURLIST_T std::vector<CONTOUR_T>
 
 namespace taurus::tracking
 {
-	void maskBrightBlobs(const cv::Mat& frame, cv::Mat& masked, cv::Mat& mask);
+	// per-camera detector settings
+	struct DetectorOptions {
+		// optional, only used if it was built for exactly these objects' colors, in the same order
+		const ColorLut* colorLut = nullptr;
+		CenterEstimator centerEstimator = Center_CIRCLE_FIT;
+		// lost objects are searched for on a frame downsampled by this factor first, and only the best candidates are refined at full resolution
+		// 1 (or less) searches the whole frame at full resolution instead
+		int reacquireScale = 4;
+		// layout of raw (CV_8UC1) frames, those are gated on the mosaic and only demosaiced around bright spots
+		BayerPattern bayerPattern = PS3EYE_BAYER_PATTERN;
+		// balls whose surroundings didn't change since their last detection keep it, instead of being segmented again (see isBallAtRest)
+		bool motionGating = true;
+		// balls found in the previous frame are followed with a few mean-shift iterations (see meanShiftBlob), and only labeled in full every few frames
+		// or when the mean-shift result isn't trustworthy
+		bool incrementalTracking = true;
+		// optional, frame sized CV_8UC1, the pixels it's set on are static lights (see StaticLightMask) and never become blobs
+		const cv::Mat* staticLights = nullptr;
+	};
+
+	void maskBrightBlobs(const cv::Mat& frame, cv::Mat& masked, cv::Mat& mask, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
 	CONTOURLIST_T findContours(const cv::Mat& mask);
 	cv::Rect fitNewRoi(cv::Point2f& globalCenter, int roiSize=240);
 
 	cv::Rect findLargestBlob(const cv::Mat& mask, cv::Point2f& circleCenter, float& circleRadius);
+	// the frame is either BGR or a raw bayer mosaic (see DetectorOptions::bayerPattern)
 	bool findSingleBall(const cv::Mat& frame, TrackedObject& obj, int cameraIndex);
-	void findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject>& objects, int cameraIndex);
-	void findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject*>& objects, int cameraIndex);
+	void findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject>& objects, int cameraIndex, const DetectorOptions& options = {});
+	void findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject*>& objects, int cameraIndex, const DetectorOptions& options = {});
 }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/segmentation.h"
+
+namespace taurus::tracking
+{
+	// a ball found in the previous frame is followed with a few mean-shift iterations instead of being labeled again
+	// a ball sized window moves onto the centroid of the pixels in it that are bright and pass the ball's color range, until it settles
+
+	// result of a mean-shift search, in the coordinates of the class image
+	struct MeanShiftResult {
+		cv::Rect window = {};  // the settled window, clipped to the class image
+		cv::Rect bounds = {};  // of the ball's pixels in the window
+		cv::Point2f centroid = {};
+		int area = 0;  // ball pixels in the window
+		int iterations = 0;
+		bool converged = false;
+	};
+
+	// the class image comes from classifyRoi, colorIndex is the color bit of the ball
+	// returns false if the window lost the ball or didn't settle within maxIterations
+	bool meanShiftBlob(const cv::Mat& classes, int colorIndex, const cv::Point2f& start, float halfSize, int maxIterations, MeanShiftResult& result);
+}
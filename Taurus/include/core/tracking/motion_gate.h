@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/tracking_utils.h"
+
+namespace taurus::tracking
+{
+	// a detected ball whose surroundings didn't change since its last full detection keeps that detection, instead of being segmented again
+	// the check is a sum of absolute differences over a small patch around the ball, against the patch of the last full detection
+	// (not the previous frame, so a slow drift adds up until the ball is detected again)
+
+	// sum of absolute differences of two byte arrays
+	uint64_t sumAbsDiff(const uchar* a, const uchar* b, int count);
+
+	// the frame (same format as when the patch was captured) still shows the ball at rest, so its previous detection can be reused
+	bool isBallAtRest(const cv::Mat& frame, const TrackedObject::PerCameraData& data);
+	// keeps the pixels around a freshly detected ball for the next frames' checks
+	void captureRestPatch(const cv::Mat& frame, TrackedObject::PerCameraData& data);
+
+	// returns the name of the instruction set the difference kernel was compiled with
+	const char* motionGateKernelName();
+}
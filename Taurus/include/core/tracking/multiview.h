@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/tracking_utils.h"
+#include "core/tracking/undistortion.h"
+
+namespace taurus::tracking
+{
+	// a calibrated camera as the triangulation sees it, in the frame the projections are relative to (camera 0)
+	struct TriangulationCamera {
+		bool valid = false;  // cameras without an extrinsic calibration still detect, but can't triangulate
+		cv::Matx34d P;
+		cv::Matx33d invM;  // inverse of P's left 3x3, turns pixels into ray directions
+		cv::Vec3d center;
+		double pixelScale = 1.0;  // pixels per unit of the observed coordinates, the focal length for normalized coordinates
+	};
+
+	// P projects into the coordinates the camera's views are given in, K * T for pixels, T alone for normalized coordinates
+	TriangulationCamera createTriangulationCamera(const cv::Mat& P, double pixelScale = 1.0);
+	// normalized coordinates through the camera's undistortion grid if it has one, otherwise the (distorted) pixels with P
+	TriangulationCamera createTriangulationCamera(const cv::Mat& P, const cv::Mat& T, const UndistortionGrid& grid);
+
+	// one camera's observation of a ball
+	struct ViewObservation {
+		int camera = 0;  // index into the triangulation cameras
+		cv::Point2f point = {};  // pixels or normalized coordinates, whatever the camera's P projects to
+		float weight = 1.f;  // inverse of the expected pixel error
+	};
+
+	// the view of a tracked ball at the reference time (see alignedCenter), looked up in the camera's undistortion grid if it has one
+	ViewObservation createViewObservation(int camera, const TrackedObject::PerCameraData& data, const UndistortionGrid& grid, int64_t referenceUs);
+
+	// the weight a detected ball gets, a larger ball's center is found more precisely (more edge pixels)
+	float observationWeight(float circleRadius);
+
+	// more views than this rarely improve the solution, but every view costs
+	constexpr size_t MAX_TRIANGULATION_VIEWS = 4;
+
+	// keeps at most maxViews views, best conditioned first: the pair of rays closest to perpendicular, then the views adding the most angle to them
+	void selectTriangulationViews(const std::vector<TriangulationCamera>& cameras, std::vector<ViewObservation>& views, size_t maxViews = MAX_TRIANGULATION_VIEWS);
+
+	// one point of a triangulation batch, the views are stored inline so a batch never allocates
+	struct TriangulationPoint {
+		std::array<ViewObservation, MAX_TRIANGULATION_VIEWS> views = {};
+		size_t viewCount = 0;
+
+		// copies up to MAX_TRIANGULATION_VIEWS views, select them first if there can be more
+		void SetViews(const std::vector<ViewObservation>& views);
+
+		// results
+		bool valid = false;
+		cv::Point3f position = {};  // in the frame of the projections
+		float residual = 0.f;  // RMS reprojection error over the views, pixels
+	};
+
+	// weighted linear triangulation of every point in the batch, from its two or more views
+	// solved once, then again with every view's rows scaled by its projective depth, so each view counts by its pixel error and weight
+	// a point is invalid with fewer than two views, (nearly) parallel rays, or if it ends up behind a camera
+	void triangulateBatch(const std::vector<TriangulationCamera>& cameras, std::vector<TriangulationPoint>& points);
+	bool triangulatePoint(const std::vector<TriangulationCamera>& cameras, TriangulationPoint& point);
+
+	// position of a ball only one camera sees, in the frame of the projections
+	// the direction is the view's ray, the distance comes from how large the ball of known size (BALL_RADIUS_CM) appears, radius is the detected one in pixels
+	// uncertainty is the standard deviation of that distance, it's mostly the radius error and grows with the square of the distance
+	bool estimateMonocularPosition(const TriangulationCamera& camera, const ViewObservation& view, float radius, cv::Point3f& position, float& uncertainty);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace taurus::tracking
+{
+	// a rectangle of the frame that gets segmented in one pass, and the rois (by index) that it covers
+	struct SegmentRegion {
+		cv::Rect bounds = {};
+		std::vector<size_t> members;
+	};
+
+	// merges the rois of a single camera into as few regions as possible without processing more pixels than the rois themselves
+	// if wholeFrame is set, a single region covering the entire frame is returned instead
+	void planRegions(const cv::Mat& frame, const std::vector<cv::Rect>& rois, bool wholeFrame, std::vector<SegmentRegion>& regions);
+
+	// amount of pixels the planned regions cover, useful for checking how much work the planner saved
+	size_t regionPixelCount(const std::vector<SegmentRegion>& regions);
+}
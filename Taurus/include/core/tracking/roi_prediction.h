@@ -0,0 +1,28 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <glm/glm.hpp>
+
+namespace taurus::tracking
+{
+	// radius of the PS Move ball, in world units (cm)
+	constexpr float BALL_RADIUS_CM = 2.25f;
+
+	// everything needed to project a world position into a single camera
+	struct CameraProjection {
+		bool valid = false;
+		cv::Matx34d worldToImage = {};  // P * world^-1, world being the transform of the triangulation frame
+		double focalLength = 0.0;
+		cv::Size frameSize = {};
+	};
+
+	// P and K of the camera, world of the camera the triangulation is done in (origin camera)
+	CameraProjection createCameraProjection(const cv::Mat& P, const cv::Mat& K, const cv::Mat& originWorld, const cv::Size& frameSize);
+
+	// projects a world position into the camera, returns false if it's behind the camera
+	bool projectWorldPoint(const CameraProjection& projection, const glm::vec3& worldPosition, cv::Point2f& imagePoint, float& depth);
+
+	// roi around the projected ball, sized from the ball radius at that depth plus the position uncertainty (world units)
+	// returns false if the ball would be behind the camera or outside of the frame
+	bool predictRoi(const CameraProjection& projection, const glm::vec3& worldPosition, float positionUncertainty, cv::Rect& roi);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/tracking_utils.h"
+#include "core/tracking/brightness.h"
+
+namespace taurus::tracking
+{
+	class ColorLut;
+
+	// maximum amount of color ranges a single segmentation pass can test against
+	constexpr size_t MAX_SEGMENT_COLORS = 7;
+
+	// bit layout of a classified pixel, bit 7 is the (opened) brightness gate, bits 0-6 are the color ranges
+	constexpr uchar CLASS_BRIGHT_BIT = 0x80;
+	constexpr uchar CLASS_COLOR_BITS = 0x7f;
+
+	// fused single-pass segmentation of a BGR frame, only inside the given roi
+	// reads every BGR pixel once and does the brightness gate, a 3x3 open (noise rejection) and the hsv range test for every color
+	// writes one binary mask (roi sized, CV_8UC1, 0 or 255) per color range
+	void segmentRoi(const cv::Mat& frame, const cv::Rect& roi, const std::vector<HsvColorRange>& colors, std::vector<cv::Mat>& masks, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
+	void segmentRoi(const cv::Mat& frame, const cv::Rect& roi, const HsvColorRange& color, cv::Mat& mask, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
+
+	// same pass as segmentRoi, but writes a single roi sized class image (CV_8UC1) with the bit layout above instead of one mask per color
+	// pixels removed by the opening are 0
+	void classifyRoi(const cv::Mat& frame, const cv::Rect& roi, const std::vector<HsvColorRange>& colors, cv::Mat& classes, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
+	// same as above, but the brightness gate and the color tests come from a precomputed lookup table
+	// a brightThreshold above the table's own gate is tested per pixel on top of it
+	void classifyRoi(const cv::Mat& frame, const cv::Rect& roi, const ColorLut& colorLut, cv::Mat& classes, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
+
+	// same classification without the opening, for frames that were already downsampled (the area filter takes care of the noise there,
+	// and a 3x3 opening would remove balls that are only a few pixels wide)
+	void classifyRoiUnopened(const cv::Mat& frame, const cv::Rect& roi, const std::vector<HsvColorRange>& colors, cv::Mat& classes, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
+
+	// returns the name of the instruction set the segmentation kernel was compiled with
+	const char* segmentationKernelName();
+}
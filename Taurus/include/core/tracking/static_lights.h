@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace taurus::tracking
+{
+	// per-camera model of the bright things that never move (lamps, monitors, windows), which the detector skips
+	// learned at startup while the controllers are dark, then slowly kept up to date around the tracked balls
+	// BGR frames are judged by gray, bayer mosaics by their raw samples
+	class StaticLightMask {
+		public:
+			void Reset(const cv::Size& frameSize);
+
+			// adds a frame of the learning phase, nothing in it may be a controller
+			void Learn(const cv::Mat& frame);
+			// pixels that were bright in most of the learning frames become static lights
+			// without any learned frame the mask never becomes ready
+			void FinishLearning();
+
+			// slow update with a tracking frame, the excluded rects (the tracked balls' rois) are left as they are, so a controller held still never fades into the background
+			void Update(const cv::Mat& frame, const std::vector<cv::Rect>& excluded);
+
+			bool IsReady() const;
+			// frame sized CV_8UC1, 255 on static lights (grown by a margin for their glow), 0 elsewhere
+			const cv::Mat& GetMask() const;
+			int GetSuppressedPixels() const;
+
+		private:
+			void FindBright(const cv::Mat& frame);
+			void RebuildMask();
+
+			cv::Mat bright;  // scratch, 255 where the current frame is bright
+			cv::Mat brightFraction;  // CV_32F, how often every pixel was bright
+			cv::Mat staticCore;  // the static lights before the margin, for the hysteresis
+			cv::Mat mask;
+			int learnedFrames = 0;
+			bool ready = false;
+	};
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/blob_labeling.h"
+#include "core/tracking/segmentation.h"
+
+namespace taurus::tracking
+{
+	enum CenterEstimator {
+		Center_BLOB_CENTROID,       // centroid of the binary blob, quantized to the mask
+		Center_INTENSITY_CENTROID,  // brightness weighted centroid around the blob
+		Center_CIRCLE_FIT           // least squares circle fit on the blob's edge, robust to partial occlusion
+	};
+
+	// center of the blob in frame coordinates, with subpixel precision depending on the estimator
+	// classes is the class image the blob was labeled from, its top left corner is at classesOffset in the frame
+	// returns false if the estimator couldn't run, in which case the blob centroid is returned
+	bool estimateBallCenter(const cv::Mat& frame, const cv::Mat& classes, const cv::Point& classesOffset, const BlobStats& blob, CenterEstimator estimator, cv::Point2f& center, float& radius, int brightThreshold = DEFAULT_BRIGHT_THRESHOLD);
+
+	// "blob", "intensity" or "circle_fit", returns false for unknown names
+	bool centerEstimatorFromName(const std::string& name, CenterEstimator& estimator);
+	const char* centerEstimatorName(CenterEstimator estimator);
+}
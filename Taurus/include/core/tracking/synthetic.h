@@ -0,0 +1,21 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/tracking_utils.h"
+
+namespace taurus::tracking
+{
+	// fills the frame with a dark, slightly noisy background, similar to what a PS3 Eye gives in dark exposure mode
+	void renderDarkBackground(cv::Mat& frame, cv::RNG& rng, double mean = 6.0, double stddev = 3.0);
+
+	// renders a glowing ball (bgr color) at a subpixel center
+	// the edge is anti-aliased by pixel coverage, so the true center of the rendered ball is exactly `center`
+	void renderGlowingBall(cv::Mat& frame, const cv::Point2f& center, float radius, const cv::Scalar& color, float glow = 0.15f);
+
+	// renders a bright, slightly warm static light (lamp, monitor, window) into the given rect
+	void renderStaticLight(cv::Mat& frame, const cv::Rect& rect, double brightness = 220.0);
+
+	// returns the hsv range the color calibrator would produce for a given rendered bgr color
+	HsvColorRange hsvRangeFromBgr(const cv::Scalar& color);
+}
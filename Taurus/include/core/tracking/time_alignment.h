@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+#include "core/tracking/tracking_utils.h"
+
+namespace taurus::tracking
+{
+	// the cameras free-run, so their views of a generation are up to a frame period apart
+	// observations are moved along their image velocity to one reference time before they're triangulated
+
+	// detections further apart than this don't give a velocity, the ball could have done anything inbetween
+	constexpr int64_t MAX_IMAGE_VELOCITY_GAP_US = 50000;
+	// observations are moved at most this far in time, a bit over a frame period at 60 fps
+	constexpr int64_t MAX_TIME_ALIGNMENT_US = 25000;
+
+	// when a camera's sensor read its rows, a rolling shutter reads them one after another (and the frame timestamp is the last one)
+	struct RowTiming {
+		int64_t rowReadoutNs = 0;  // 0 is a global shutter, every row at the frame timestamp
+		int rows = 0;
+	};
+
+	// capture time of the image row a detection is on, rows are sampled earlier the further up they are
+	int64_t rowTimestampUs(int64_t frameTimestampUs, const RowTiming& timing, float row);
+
+	// records the capture time of a camera's detection and updates its image velocity from the previous detection
+	// timestampUs should be the detection's row time (rowTimestampUs), so the velocity and the alignment hold for rolling shutters too
+	// call once per camera frame, after the detections have their final objects (same color matching swaps them)
+	void updateImageMotion(TrackedObject::PerCameraData& data, int64_t timestampUs);
+
+	// the detection's center at the reference time, extrapolated with its image velocity (unchanged without one)
+	cv::Point2f alignedCenter(const TrackedObject::PerCameraData& data, int64_t referenceUs);
+}
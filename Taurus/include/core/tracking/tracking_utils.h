@@ -1,9 +1,11 @@
 #pragma once
 
+#include <limits>
 #include <opencv2/opencv.hpp>
 #include <glm/glm.hpp>
 
 #include "core/filter/filter_utils.h"
+#include "core/tracking/brightness.h"
 
 namespace taurus::tracking
 {
@@ -13,11 +15,27 @@ namespace taurus::tracking
 	};
 
 	struct TrackedObject {
+		// how a ball's detection moves in one camera's image, kept with the object when detections are reassigned
+		struct ImageMotion {
+			cv::Point2f previousCenter = {};
+			int64_t previousTimestampUs = 0;  // 0 before the first detection
+			cv::Point2f velocity = {};  // pixels/s
+			bool hasVelocity = false;
+		};
+
 		struct PerCameraData {
 			cv::Rect roi = {};
 			HsvColorRange color = {};
 
+			// the roi was predicted from the 3D state, the detector searches it even if tracking was lost
+			bool roiPredicted = false;
+			// where the 3D state expects the ball, kept after the detection (unlike the roi) so the detection can be checked against it
+			bool hasPrediction = false;
+			cv::Point2f predictedCenter = {};
+
 			bool acquiredTracking = false;
+			// brightness gate of the roi, adapted to the room around the ball
+			AdaptiveThreshold brightness = {};
 
 			cv::Point2f inRoiCircleCenter = {};
 			cv::Rect inRoiBounds = {};
@@ -25,23 +43,47 @@ namespace taurus::tracking
 
 			cv::Point2f globalCircleCenter = {};
 			cv::Rect globalBounds = {};
+
+			// the pixels around the ball at its last full detection (see isBallAtRest), and how many frames since reused that detection
+			cv::Mat restPatch = {};
+			cv::Rect restRect = {};
+			int reusedFrames = 0;
+			bool reusedDetection = false;  // this frame's detection is the previous one, the ball didn't move
+
+			// ball pixels of the last detection, and how many frames in a row it was tracked incrementally (see meanShiftBlob)
+			int trackedPixels = 0;
+			int incrementalFrames = 0;
+			bool incrementalDetection = false;  // this frame's detection came from the mean-shift tracker, not from labeling
+
+			// capture time of the detection (captureClockUs), the cameras aren't synchronized
+			int64_t timestampUs = 0;
+			ImageMotion motion = {};
 		};
 
 		std::vector<PerCameraData> perCameraData;
 
 		// 3d tracking
 		cv::Point3f triangulatedPosition = {};
+		float reprojectionResidual = 0.f;  // RMS pixel error of the triangulated position in the cameras that saw it
 		bool acquired3DPosition = false;
 		bool newOpticalDataReady = false;
+		// only one camera saw the ball, the depth comes from the ball's size and is a lot less certain
+		bool monocularPosition = false;
+		float positionUncertainty = 0.f;  // cm, standard deviation of the optical position
 
-		// after world transform
+		// after world transform, the positions are at the generation's time (the views are aligned to it)
+		int64_t opticalTimestampUs = 0;
 		glm::vec3 worldPosition = {};
 		glm::vec3 previousWorldPosition = {};
+		bool previousMonocularPosition = false;  // the previous position's depth came from the ball's size, no velocity is differenced against it
 
 		// optical prediction
 		glm::vec3 opticalVelocity = {};
+		float timeSinceOpticalFix = std::numeric_limits<float>::infinity();  // seconds, an object that never had a fix has nothing to predict from
 
 		// filtering
+		glm::vec3 opticalAnchor = {};  // the optical positions fused so far, the IMU kinematics integrate from here
+		float anchorUncertainty = 1e4f;  // cm, nothing is known before the first optical position
 		glm::vec3 preFilteredPosition = {};
 		glm::vec3 filteredPosition = {};
 		glm::vec3 previousFilteredPosition = {};
@@ -66,8 +108,6 @@ namespace taurus::tracking
 
 	void drawEpilines(cv::Mat& frame, std::vector<cv::Point3f>& lines, cv::Scalar color);
 
-	cv::Point2f undistort(const cv::Point2f& point, const cv::Mat& K, const cv::Mat& distort);
-	cv::Point3f triangulate(const cv::Mat& P1, const cv::Mat& P2, TrackedObject::PerCameraData& cam0Data, TrackedObject::PerCameraData& cam1Data);
 	cv::Point3f transform(const cv::Mat& mat4x4, const cv::Point3f& point);
 
 	glm::vec3 cvPoint3fToGlmVec3(const cv::Point3f& point);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace taurus::tracking
+{
+	// pixels between the nodes of the grid, the PS3 Eye's distortion barely bends over that distance, so the bilinear lookup stays far below a pixel off
+	constexpr int UNDISTORTION_GRID_STEP = 8;
+
+	// normalized image coordinates (undistorted, focal length 1) of a regular grid of pixels, solved once per calibration
+	// a lookup interpolates between the four nodes around the point, instead of solving the distortion model iteratively per point
+	class UndistortionGrid {
+		public:
+			// the grid reaches a node past the right and bottom frame edge, so every pixel of the frame has four nodes around it
+			void Build(const cv::Mat& K, const cv::Mat& distort, const cv::Size& frameSize, int step = UNDISTORTION_GRID_STEP);
+			void Clear();
+
+			bool IsBuilt() const;
+			// pixels per normalized unit, turns normalized errors back into pixels
+			double GetFocalLength() const;
+
+			// points outside of the frame are clamped to its border nodes
+			inline cv::Point2f Lookup(const cv::Point2f& pixel) const {
+				float gx = std::clamp(pixel.x * inverseStep, 0.f, static_cast<float>(columns - 1));
+				float gy = std::clamp(pixel.y * inverseStep, 0.f, static_cast<float>(rows - 1));
+				int x = std::min(static_cast<int>(gx), columns - 2);
+				int y = std::min(static_cast<int>(gy), rows - 2);
+				float fx = gx - x;
+				float fy = gy - y;
+
+				const cv::Point2f* top = &nodes[y * columns + x];
+				const cv::Point2f* bottom = top + columns;
+				cv::Point2f upper = top[0] + (top[1] - top[0]) * fx;
+				cv::Point2f lower = bottom[0] + (bottom[1] - bottom[0]) * fx;
+				return upper + (lower - upper) * fy;
+			}
+
+		private:
+			std::vector<cv::Point2f> nodes;  // row major
+			int columns = 0;
+			int rows = 0;
+			float inverseStep = 0.f;
+			double focalLength = 1.0;
+	};
+}
@@ -0,0 +1,78 @@
+/*
+FILE DESCRIPTION:
+
+Entry-point for the benchmark tool, which runs micro-benchmarks of the tracking pipeline on synthetic data (no hardware needed)
+*/
+
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "benchmark/center_benchmark.h"
+#include "benchmark/pipeline_benchmark.h"
+#include "benchmark/segmentation_benchmark.h"
+#include "benchmark/triangulation_benchmark.h"
+#include "core/logging.h"
+
+namespace logging = taurus::logging;
+
+int main() {
+	// Print available modes
+	logging::info("---------------");
+	logging::info("Available benchmarks:");
+	logging::info("[name - letter - args]");
+	logging::info("segmentation - s - [iterations]");
+	logging::info("center estimation - c - [iterations]");
+	logging::info("synthetic pipeline - p - [cameras] [balls] [frames] [fps] [bayer 0/1]");
+	logging::info("triangulation - t - [iterations]");
+	logging::info("---------------");
+
+	// get input
+	logging::info("Enter benchmark letter with args separated by spaces -> ");
+	std::string input;
+	std::getline(std::cin, input);
+	std::istringstream inputStream = std::istringstream(input);
+
+	// tokenize
+	std::vector<std::string> tokens;
+	std::string s;
+	while (std::getline(inputStream, s, ' ')) {
+		tokens.push_back(s);
+	}
+
+	if (tokens.empty()) {
+		logging::error("No benchmark given!");
+		return 1;
+	}
+
+	// run the benchmark
+	std::string command = tokens[0];
+	if (command == "s") {
+		taurus::benchmark::runSegmentationBenchmark(tokens.size() > 1 ? std::stoi(tokens[1]) : 500);
+	}
+	else if (command == "c") {
+		taurus::benchmark::runCenterBenchmark(tokens.size() > 1 ? std::stoi(tokens[1]) : 200);
+	}
+	else if (command == "p") {
+		taurus::benchmark::runPipelineBenchmark(
+			tokens.size() > 1 ? std::stoi(tokens[1]) : 2,
+			tokens.size() > 2 ? std::stoi(tokens[2]) : 2,
+			tokens.size() > 3 ? std::stoi(tokens[3]) : 600,
+			tokens.size() > 4 ? std::stoi(tokens[4]) : 60,
+			tokens.size() > 5 && tokens[5] == "1"
+		);
+	}
+	else if (command == "t") {
+		taurus::benchmark::runTriangulationBenchmark(tokens.size() > 1 ? std::stoi(tokens[1]) : 2000);
+	}
+	else {
+		logging::error("Invalid benchmark!");
+	}
+
+	// wait for input
+	logging::info("Press any key to exit...");
+	std::getline(std::cin, input);
+
+	return 0;
+}
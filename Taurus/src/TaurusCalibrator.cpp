@@ -62,6 +62,7 @@ int main() {
 	logging::info("extrinsic - e - cSerial, camId0, camId1");
 	logging::info("---------------");
 	logging::info("To correctly calibrate from zero, do it in the same order as the mode list.");
+	logging::info("With more than two cameras, calibrate every other camera's extrinsics against cam 0 (e - cSerial, 0, camId).");
 
 	// get input
 	logging::info("Enter calibration mode letter with args separated by spaces -> ");
@@ -10,6 +10,7 @@ Subthread which manages the communication (sending tracking/status data, receivi
 #include <psmoveapi/psmove.h>
 
 #include "core/logging.h"
+#include "core/session_recorder.h"
 #include "core/utils.h"
 
 #include "app/optical_thread.h"
@@ -276,6 +277,11 @@ void taurus::CommunicationThread::SendMsg(messages::TaurusMessage& msg) const {
 	char buffer[1024];
 	sock::SerializeTaurusMsg(msg, buffer);
 	sock::SendData(sendSock, sendPort, buffer, static_cast<int>(msg.ByteSizeLong()));
+
+	SessionRecorder* recorder = SessionRecorder::GetInstance();
+	if (recorder != nullptr && recorder->IsRecording()) {
+		recorder->RecordMessage(buffer, msg.ByteSizeLong());
+	}
 }
 
 void taurus::CommunicationThread::InterruptRecvSocket() const {
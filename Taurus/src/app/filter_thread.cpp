@@ -6,9 +6,18 @@ Subthread which manages the filtering of the tracking data, as well as post proc
 
 #include "app/filter_thread.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "core/filter/lowpass.h"
+#include "core/frame_ring.h"
 #include "core/logging.h"
 
+// how fast the IMU position drifts from the truth, cm/s, decides how much a monocular position is trusted over it
+static constexpr float DEAD_RECKONING_DRIFT = 30.f;
+// optical positions are moved up to this far (s) to the present with their velocity, older ones are taken as they are
+static constexpr float MAX_OPTICAL_LATENCY = 0.05f;
+
 taurus::FilterThread::FilterThread() {
 	this->config = TaurusConfig::GetInstance();
 	this->controllers = ControllerManager::GetInstance();
@@ -53,12 +62,29 @@ void taurus::FilterThread::ThreadFunc() {
 
 			// if we've got optical data (reliable but slow), use it and reset the IMU kinematics
 			if (obj->newOpticalDataReady) {
+				// a triangulated position is taken as it is, a monocular one (uncertain depth) is only blended in by how uncertain the IMU position has become
+				float gain = 1.f;
+				if (obj->monocularPosition) {
+					float imuVariance = obj->anchorUncertainty * obj->anchorUncertainty;
+					float opticalVariance = obj->positionUncertainty * obj->positionUncertainty;
+					gain = imuVariance / std::max(imuVariance + opticalVariance, 1e-6f);
+				}
+
+				// the optical position is from the capture time of its generation, the ball kept moving during detection and triangulation
+				float opticalLatency = static_cast<float>(captureClockUs() - obj->opticalTimestampUs) / 1000000.f;
+				glm::vec3 opticalPosition = obj->worldPosition;
+				if (opticalLatency > 0.f && opticalLatency <= MAX_OPTICAL_LATENCY) opticalPosition += obj->opticalVelocity * opticalLatency;
+
 				// request the optical position to be the one for filtering
-				obj->preFilteredPosition = obj->worldPosition;
+				glm::vec3 imuPosition = obj->opticalAnchor + obj->kinematic.GetPosition();
+				obj->opticalAnchor = imuPosition + (opticalPosition - imuPosition) * gain;
+				obj->anchorUncertainty = obj->monocularPosition ? obj->anchorUncertainty * std::sqrt(1.f - gain) : obj->positionUncertainty;
+				obj->preFilteredPosition = obj->opticalAnchor;
 
 				// reset kinematic state and update the velocity with the new reliable optical velocity
+				glm::vec3 imuVelocity = obj->kinematic.GetVelocity();
 				obj->kinematic.SetPosition(glm::vec3(0.f));
-				obj->kinematic.SetVelocity(obj->opticalVelocity);
+				obj->kinematic.SetVelocity(imuVelocity + (obj->opticalVelocity - imuVelocity) * gain);
 
 				// we've handled the new data, so reset the flag
 				obj->newOpticalDataReady = false;
@@ -67,7 +93,8 @@ void taurus::FilterThread::ThreadFunc() {
 				// we are inbetween optical measurements or we've lost tracking
 				// integrate IMU kinematics and use it as the position
 				obj->kinematic.Integrate(secPassed);
-				obj->preFilteredPosition = obj->worldPosition + obj->kinematic.GetPosition();
+				obj->anchorUncertainty += DEAD_RECKONING_DRIFT * secPassed;
+				obj->preFilteredPosition = obj->opticalAnchor + obj->kinematic.GetPosition();
 			}
 
 			// apply a filter, to reduce noise
@@ -1,14 +1,39 @@
 /*
 FILE DESCRIPTION:
 
-Subthread which manages the optical tracking system
+Subthreads which manage the optical tracking system, one detection worker per camera reading that camera's frame ring
+the workers meet at a barrier after every frame, where the observations get triangulated
 */
 
 #include "app/optical_thread.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "core/tracking/assignment.h"
+#include "core/tracking/time_alignment.h"
 #include "core/utils.h"
 #include "core/logging.h"
 
+// roi prediction tuning, world units are cm
+static constexpr float ROI_PREDICTION_TIMEOUT = 0.5f;  // seconds without a 3D position before the prediction is given up
+static constexpr float BASE_POSITION_UNCERTAINTY = 2.f;  // cm, triangulation noise and filter lag
+static constexpr float VELOCITY_UNCERTAINTY_GAIN = 0.5f;  // fraction of the predicted motion that may be wrong
+static constexpr float LOST_UNCERTAINTY_GROWTH = 100.f;  // cm/s, how fast the uncertainty grows while tracking is lost
+
+// standard deviation of a triangulated position, cm
+static constexpr float TRIANGULATED_POSITION_UNCERTAINTY = 0.5f;
+
+// static light learning, in generations
+static constexpr int STATIC_LIGHT_SETTLE_FRAMES = 15;  // the controllers' leds take a moment to go dark
+static constexpr int STATIC_LIGHT_LEARN_FRAMES = 30;
+static constexpr uint64_t STATIC_LIGHT_UPDATE_INTERVAL = 30;  // camera frames between two updates of a learned mask
+
+// blink code identification
+static constexpr int64_t BLINK_SETTLE_US = 200000;  // the leds take a moment to start blinking (or to light up again after the static lights)
+static constexpr int BLINK_CODE_PERIODS = 3;  // code periods sampled before the controllers are identified
+static constexpr float MIN_BLINK_CORRELATION = 0.85f;  // the other codes reach about 0.75 on a clean ball
+
 taurus::OpticalThread* taurus::OpticalThread::instance = nullptr;
 
 taurus::OpticalThread* taurus::OpticalThread::GetInstance() {
@@ -25,14 +50,53 @@ taurus::OpticalThread::OpticalThread() {
 	this->cameraManager = CameraManager::GetInstance();
 	cameraCount = cameraManager->GetCameraCount();
 
-	Camera& camera0 = cameraManager->GetCamera(0);
-	camera0.SetExposureMode(Exposure_DARK);
-	Camera& camera1 = cameraManager->GetCamera(1);
-	camera1.SetExposureMode(Exposure_DARK);
+	// every camera calibrated against cam 0 takes part in the triangulation, the others only track in 2D
+	calibrations = std::vector<CameraCalibration>();
+	triangulationCameras = std::vector<tracking::TriangulationCamera>();
+	for (int i = 0; i < cameraCount; i++) {
+		Camera& cam = cameraManager->GetCamera(i);
+		cam.SetExposureMode(Exposure_DARK);
+
+		CameraCalibration calib = cam.GetCalibration();
+		tracking::TriangulationCamera triangulationCamera;
+		if (calib.hasProjection) triangulationCamera = tracking::createTriangulationCamera(calib.P, calib.T, cam.GetUndistortionGrid());
+		if (!triangulationCamera.valid) {
+			logging::warning("Cam %d has no usable projection, it won't be triangulated", i);
+		}
+
+		calibrations.push_back(calib);
+		triangulationCameras.push_back(triangulationCamera);
+		undistortionGrids.push_back(&cam.GetUndistortionGrid());
+	}
+	epipolarGeometry.Build(triangulationCameras);
+
+	// every camera worker reads its camera's frame ring with its own cursor, so the preview can't steal its frames
+	frameSizes = std::vector<cv::Size>();
+	for (int i = 0; i < cameraCount; i++) {
+		frameSizes.push_back(cameraManager->GetCamera(i).InitFrameMat().size());
+	}
+	frameCursors = std::vector<FrameCursor>(cameraCount);
+	for (FrameCursor& cursor : frameCursors) {
+		// a replay that isn't realtime waits for the workers, so they see every recorded frame
+		cursor.pacesProducer = true;
+	}
+	frameTimestamps = std::vector<int64_t>(cameraCount, 0);
 
-	calib0 = camera0.GetCalibration();
-	calib1 = camera1.GetCalibration();
-	frame = camera0.InitFrameMat();
+	// rolling shutter cameras time every detection by its row
+	rowTimings = std::vector<tracking::RowTiming>();
+	for (int i = 0; i < cameraCount; i++) {
+		tracking::RowTiming timing = cameraManager->GetCamera(i).GetRowTiming();
+		if (timing.rowReadoutNs > 0) {
+			logging::info("Cam %d: rolling shutter, %.2f ms from the first to the last row", i, static_cast<double>(timing.rowReadoutNs) * (timing.rows - 1) / 1000000.0);
+		}
+		rowTimings.push_back(timing);
+	}
+
+	// projections of world positions into every camera, for the roi prediction
+	projections = std::vector<tracking::CameraProjection>();
+	for (int i = 0; i < cameraCount; i++) {
+		projections.push_back(tracking::createCameraProjection(calibrations[i].P, calibrations[i].K, calibrations[0].world, frameSizes[i]));
+	}
 
 	// init the tracked object list for every controller
 	trackedObjects = std::vector<tracking::TrackedObject*>();
@@ -47,25 +111,110 @@ taurus::OpticalThread::OpticalThread() {
 			tracking::TrackedObject::PerCameraData data;
 			data.acquiredTracking = false;
 			data.color = cam.GetHsvColorRange(controller->GetColorName());
-			data.roi = tracking::createFrameRoi(frame);
+			data.roi = cv::Rect(cv::Point(0, 0), frameSizes[i]);
 
 			obj->perCameraData.push_back(data);
 		}
 
 		trackedObjects.push_back(obj);
 	}
+	triangulationPoints = std::vector<tracking::TriangulationPoint>(trackedObjects.size());
+
+	// controllers of the same color can only be told apart by where their balls are
+	sameColorGroups = std::vector<std::vector<tracking::TrackedObject*>>();
+	std::vector<bool> grouped = std::vector<bool>(connectedControllers.size(), false);
+	for (size_t i = 0; i < connectedControllers.size(); i++) {
+		if (grouped[i]) continue;
+
+		std::string colorName = controllers->GetController(connectedControllers[i])->GetColorName();
+		std::vector<tracking::TrackedObject*> group;
+		for (size_t j = i; j < connectedControllers.size(); j++) {
+			if (controllers->GetController(connectedControllers[j])->GetColorName() != colorName) continue;
+
+			grouped[j] = true;
+			group.push_back(trackedObjects[j]);
+		}
+
+		if (group.size() > 1) {
+			logging::info("%zu controllers share the color %s, they are told apart by the epipolar constraint and their predicted positions", group.size(), colorName.c_str());
+			sameColorGroups.push_back(group);
+		}
+	}
+
+	// build the color lookup tables for the controller colors, in the same order as the tracked objects
+	std::vector<std::string> trackedColors;
+	for (std::string serial : connectedControllers) {
+		trackedColors.push_back(controllers->GetController(serial)->GetColorName());
+	}
+	for (int i = 0; i < cameraCount; i++) {
+		cameraManager->GetCamera(i).SetTrackedColors(trackedColors);
+	}
+
+	// subpixel center estimator for every camera, in camera order
+	TaurusConfigStorage* configStorage = config->GetStorage();
+	if (configStorage->centerEstimators.has_value()) {
+		std::vector<std::string>& estimatorNames = configStorage->centerEstimators.value();
+		for (int i = 0; i < cameraCount && i < estimatorNames.size(); i++) {
+			tracking::CenterEstimator estimator;
+			if (tracking::centerEstimatorFromName(estimatorNames[i], estimator)) {
+				cameraManager->GetCamera(i).SetCenterEstimator(estimator);
+			}
+			else {
+				logging::warning("Unknown center estimator \"%s\" for cam %d", estimatorNames[i].c_str(), i);
+			}
+		}
+	}
+
+	// the static lights are learned with the controllers dark, replayed and rendered frames can't turn their balls off
+	staticLights = std::vector<tracking::StaticLightMask>(cameraCount);
+	bool liveCameras = !configStorage->replaySession.has_value() && configStorage->cameraSource.value_or("ps3eye") != "synthetic";
+	learnStaticLights = configStorage->staticLightSuppression.value_or(true) && liveCameras;
+
+	// same colored controllers are told apart by their positions anyway, the blink codes make sure they start out with their own balls
+	blinkDecoders = std::vector<std::vector<tracking::BlinkDecoder>>(cameraCount, std::vector<tracking::BlinkDecoder>(trackedObjects.size()));
+	identifyControllers = configStorage->blinkIdentification.value_or(false) && liveCameras && !sameColorGroups.empty();
 }
 
 void taurus::OpticalThread::Start() {
+	// the barrier's completion step only runs once every worker arrived, without cameras nothing would ever be tracked
+	if (cameraCount == 0) {
+		logging::error("No cameras to track with, the optical thread isn't started");
+		return;
+	}
+
 	threadActive.store(true);
-	thread = std::thread(&OpticalThread::ThreadFunc, this);
+	generationActive = true;
+	lastGenerationTimestamp = captureClockUs();
 
-	logging::info("Started optical thread");
+	if (learnStaticLights) {
+		logging::info("Learning the static lights, the controllers stay dark for a moment");
+		staticLightFrames = 0;
+		for (std::string& serial : connectedControllers) {
+			controllers->GetController(serial)->SetColorRaw(RGB_char{ 0, 0, 0 });
+		}
+	}
+	else if (identifyControllers) {
+		StartIdentification();
+	}
+
+	generationBarrier = std::make_unique<std::barrier<TriangulationCompletion>>(static_cast<ptrdiff_t>(cameraCount), TriangulationCompletion{ this });
+	cameraThreads = std::vector<std::thread>();
+	for (int i = 0; i < cameraCount; i++) {
+		cameraThreads.push_back(std::thread(&OpticalThread::CameraWorkerFunc, this, i));
+	}
+
+	logging::info("Started optical thread with %d camera workers", cameraCount);
 }
 
 void taurus::OpticalThread::Stop() {
 	threadActive.store(false);
-	thread.join();
+	for (std::thread& cameraThread : cameraThreads) {
+		cameraThread.join();
+	}
+
+	for (int i = 0; i < cameraCount; i++) {
+		logging::info("Cam %d: optical thread missed %llu frames, capture dropped %llu", i, frameCursors[i].droppedFrames, cameraManager->GetCamera(i).GetOverrunCount());
+	}
 }
 
 int taurus::OpticalThread::GetFps() const {
@@ -76,63 +225,336 @@ std::vector<taurus::tracking::TrackedObject*>* taurus::OpticalThread::GetTracked
 	return &trackedObjects;
 }
 
-void taurus::OpticalThread::ThreadFunc() {
-	TaurusConfigStorage* configStorage = config->GetStorage();
+void taurus::TriangulationCompletion::operator()() noexcept {
+	opticalThread->TriangulateGeneration();
+}
 
-	long lastTick = psmove_util_get_ticks();
-	long now;
-	float msPassed, secPassed;
-	while (threadActive.load()) {
-		now = psmove_util_get_ticks();
-		msPassed = static_cast<float>(now - lastTick);
-		lastTick = now;
+void taurus::OpticalThread::CameraWorkerFunc(int cameraIndex) {
+	Camera& cam = cameraManager->GetCamera(cameraIndex);
+	FrameCursor& cursor = frameCursors[cameraIndex];
+	FrameView view;
 
-		fps = roundToInt(1000.f / msPassed);
-		secPassed = msPassed / 1000.f;
+	tracking::DetectorOptions detectorOptions;
+	detectorOptions.colorLut = &cam.GetColorLut();
+	detectorOptions.centerEstimator = cam.GetCenterEstimator();
+	detectorOptions.bayerPattern = cam.GetBayerPattern();
 
-		// do for each cam
-		for (int i = 0; i < cameraCount; i++) {
-			Camera& cam = cameraManager->GetCamera(i);
-			cam.GetFrame(frame);
-
-			// track the controllers
-			tracking::findMultiBalls(frame, trackedObjects, i);
-			for (tracking::TrackedObject* obj : trackedObjects) {
-				auto& thisCameraData = obj->perCameraData[i];
-
-				if (!thisCameraData.acquiredTracking) {
-					// lost tracking
-					// increase ROI size to try and find the controller
-					tracking::increaseRoiSize(thisCameraData.roi, 100);
-					tracking::clampRoi(frame, thisCameraData.roi);
+	tracking::StaticLightMask& cameraStaticLights = staticLights[cameraIndex];
+	std::vector<cv::Rect> ballRois;
+	uint64_t trackedFrames = 0;
+
+	while (true) {
+		// a closed ring still has to meet the other workers at the barrier, it just has nothing to detect
+		if (cam.WaitFrame(cursor, view)) {
+			frameTimestamps[cameraIndex] = view.timestampUs;
+
+			if (learnStaticLights) {
+				if (staticLightFrames >= STATIC_LIGHT_SETTLE_FRAMES) cameraStaticLights.Learn(view.frame);
+				view.Release();
+
+				generationBarrier->arrive_and_wait();
+				if (!generationActive) break;
+				continue;
+			}
+
+			// track the controllers, this worker only touches this camera's per-camera data
+			// lost controllers are reacquired by the detector
+			detectorOptions.staticLights = cameraStaticLights.IsReady() ? &cameraStaticLights.GetMask() : nullptr;
+			tracking::findMultiBalls(view.frame, trackedObjects, cameraIndex, detectorOptions);
+
+			// the brightness of every ball while the controllers blink, on the detector's input (raw samples for bayer frames)
+			if (identifyControllers && view.timestampUs >= identificationStartUs) {
+				for (size_t o = 0; o < trackedObjects.size(); o++) {
+					const tracking::TrackedObject::PerCameraData& data = trackedObjects[o]->perCameraData[cameraIndex];
+					if (data.acquiredTracking) blinkDecoders[cameraIndex][o].AddSample(view.timestampUs, tracking::ballIntensity(view.frame, data.globalBounds));
 				}
 			}
+
+			// every once in a while the static lights follow the room, away from the balls
+			trackedFrames++;
+			if (cameraStaticLights.IsReady() && trackedFrames % STATIC_LIGHT_UPDATE_INTERVAL == 0) {
+				ballRois.clear();
+				for (tracking::TrackedObject* obj : trackedObjects) {
+					const tracking::TrackedObject::PerCameraData& data = obj->perCameraData[cameraIndex];
+					if (data.acquiredTracking || data.hasPrediction) ballRois.push_back(data.roi);
+				}
+				cameraStaticLights.Update(view.frame, ballRois);
+			}
+
+			// hand the buffer back to the capture thread before waiting on the other cameras
+			view.Release();
 		}
 
-		// track every controller in 3D
-		for (tracking::TrackedObject* obj : trackedObjects) {
-			// if we have tracking data from both cameras, triangulate
-			obj->acquired3DPosition = obj->perCameraData[0].acquiredTracking && obj->perCameraData[1].acquiredTracking;
-			if (obj->acquired3DPosition) {
-				// undistort
-				cv::Point2f undistorted0 = tracking::undistort(obj->perCameraData[0].globalCircleCenter, calib0.K, calib0.distort);
-				cv::Point2f undistorted1 = tracking::undistort(obj->perCameraData[1].globalCircleCenter, calib1.K, calib1.distort);
+		// wait for the other cameras, the last one to arrive triangulates
+		generationBarrier->arrive_and_wait();
+		if (!generationActive) break;
+	}
+}
+
+void taurus::OpticalThread::TriangulateGeneration() {
+	generation++;
+	generationActive = threadActive.load();
+
+	// the generation is timestamped by its latest capture
+	int64_t now = *std::max_element(frameTimestamps.begin(), frameTimestamps.end());
+	float msPassed = static_cast<float>(now - lastGenerationTimestamp) / 1000.f;
+	lastGenerationTimestamp = now;
+
+	fps = roundToInt(1000.f / msPassed);
+	float secPassed = msPassed / 1000.f;
+
+	// nothing is tracked while the static lights are learned
+	if (learnStaticLights) {
+		staticLightFrames++;
+		if (staticLightFrames >= STATIC_LIGHT_SETTLE_FRAMES + STATIC_LIGHT_LEARN_FRAMES) FinishStaticLightLearning();
+		return;
+	}
+
+	// the controllers are identified before their detections are matched, so the matching already follows the identities
+	int64_t identificationUs = static_cast<int64_t>(BLINK_CODE_PERIODS) * tracking::BLINK_CODE_BITS * tracking::BLINK_STEP_MS * 1000;
+	if (identifyControllers && now - identificationStartUs >= identificationUs) FinishIdentification();
+
+	// controllers sharing a color first get their detections sorted out across the cameras
+	for (std::vector<tracking::TrackedObject*>& group : sameColorGroups) {
+		tracking::matchSameColorObjects(triangulationCameras, undistortionGrids, epipolarGeometry, group);
+	}
 
-				// triangulate
-				obj->triangulatedPosition = tracking::triangulate(calib0.P, calib1.P, obj->perCameraData[0], obj->perCameraData[1]);
-				obj->worldPosition = tracking::cvPoint3fToGlmVec3(tracking::transform(calib0.world, obj->triangulatedPosition));
+	// every camera that sees a ball adds a view, the best conditioned ones are triangulated
+	// the views are moved to the generation's time first, the cameras (and the rows of a rolling shutter) captured them up to a frame period apart
+	for (size_t o = 0; o < trackedObjects.size(); o++) {
+		tracking::TrackedObject* obj = trackedObjects[o];
 
-				// predict
+		triangulationViews.clear();
+		for (int i = 0; i < cameraCount; i++) {
+			tracking::TrackedObject::PerCameraData& data = obj->perCameraData[i];
+			tracking::updateImageMotion(data, tracking::rowTimestampUs(frameTimestamps[i], rowTimings[i], data.globalCircleCenter.y));
+			if (!data.acquiredTracking || !triangulationCameras[i].valid) continue;
+
+			triangulationViews.push_back(tracking::createViewObservation(i, data, *undistortionGrids[i], now));
+		}
+		tracking::selectTriangulationViews(triangulationCameras, triangulationViews);
+		triangulationPoints[o].SetViews(triangulationViews);
+	}
+
+	// all controllers in one go
+	tracking::triangulateBatch(triangulationCameras, triangulationPoints);
+
+	// track every controller in 3D
+	for (size_t o = 0; o < trackedObjects.size(); o++) {
+		tracking::TrackedObject* obj = trackedObjects[o];
+		const tracking::TriangulationPoint& point = triangulationPoints[o];
+
+		obj->acquired3DPosition = point.valid;
+		obj->monocularPosition = false;
+		if (point.valid) {
+			obj->triangulatedPosition = point.position;
+			obj->reprojectionResidual = point.residual;
+			obj->positionUncertainty = TRIANGULATED_POSITION_UNCERTAINTY;
+		}
+		else if (point.viewCount > 0) {
+			// a single camera still bounds the position, instead of leaving it to the IMU alone
+			obj->acquired3DPosition = EstimateMonocularPosition(obj, point);
+			obj->monocularPosition = obj->acquired3DPosition;
+		}
+
+		if (obj->acquired3DPosition) {
+			obj->worldPosition = tracking::cvPoint3fToGlmVec3(tracking::transform(calibrations[0].world, obj->triangulatedPosition));
+
+			// predict
+			// a monocular depth is off by far more than the ball moves in a generation, a velocity across one would throw the roi and the filter off, the filter's own velocity carries on
+			if (obj->monocularPosition || obj->previousMonocularPosition) {
+				obj->opticalVelocity = obj->kinematic.GetVelocity();
+			}
+			else {
 				obj->opticalVelocity = (obj->worldPosition - obj->previousWorldPosition) / secPassed;
 				if (std::isinf(obj->opticalVelocity.x)) {
 					obj->opticalVelocity = glm::vec3(0.f);
 				}
+			}
+
+			// store last frame pos, for future filtering
+			obj->previousWorldPosition = obj->worldPosition;
+			obj->previousMonocularPosition = obj->monocularPosition;
 
-				// store last frame pos, for future filtering
-				obj->previousWorldPosition = obj->worldPosition;
+			obj->opticalTimestampUs = now;
+			obj->newOpticalDataReady = true;
+		}
+	}
+
+	PredictRois(secPassed);
+}
 
-				obj->newOpticalDataReady = true;
+void taurus::OpticalThread::FinishStaticLightLearning() {
+	for (int i = 0; i < cameraCount; i++) {
+		staticLights[i].FinishLearning();
+		logging::info("Cam %d: %d pixels of static lights are skipped", i, staticLights[i].GetSuppressedPixels());
+	}
+
+	// the controllers light up again
+	for (std::string& serial : connectedControllers) {
+		Controller* controller = controllers->GetController(serial);
+		controller->SetColor(controller->GetColorName());
+	}
+	learnStaticLights = false;
+
+	if (identifyControllers) StartIdentification();
+}
+
+void taurus::OpticalThread::StartIdentification() {
+	// every controller of a group gets its own code, the groups have different colors so their codes can repeat
+	for (std::vector<tracking::TrackedObject*>& group : sameColorGroups) {
+		if (group.size() > static_cast<size_t>(tracking::blinkCodeCount())) {
+			logging::warning("%zu controllers share a color, only %d of them can be told apart by their blink codes", group.size(), tracking::blinkCodeCount());
+		}
+
+		for (std::string& serial : connectedControllers) {
+			Controller* controller = controllers->GetController(serial);
+			auto member = std::find(group.begin(), group.end(), controller->GetTrackedObject());
+			if (member != group.end()) controller->SetBlinkCode(tracking::blinkCode(static_cast<int>(member - group.begin())));
+		}
+	}
+
+	for (std::vector<tracking::BlinkDecoder>& cameraDecoders : blinkDecoders) {
+		for (tracking::BlinkDecoder& decoder : cameraDecoders) {
+			decoder.Reset();
+		}
+	}
+	identificationStartUs = lastGenerationTimestamp + BLINK_SETTLE_US;
+	logging::info("Identifying the controllers that share a color by their blink codes");
+}
+
+namespace
+{
+	// everything the optical tracking knows about a ball, moves with the ball when controllers are identified
+	struct OpticalState {
+		std::vector<taurus::tracking::TrackedObject::PerCameraData> perCameraData;
+		cv::Point3f triangulatedPosition;
+		bool acquired3DPosition;
+		glm::vec3 worldPosition;
+		glm::vec3 previousWorldPosition;
+		bool previousMonocularPosition;
+		glm::vec3 opticalVelocity;
+	};
+}
+
+void taurus::OpticalThread::FinishIdentification() {
+	thread_local std::vector<float> costs;
+	thread_local std::vector<int> assignment;
+	thread_local std::vector<OpticalState> states;
+
+	for (std::vector<tracking::TrackedObject*>& group : sameColorGroups) {
+		int count = static_cast<int>(group.size());
+
+		// every controller's code against every ball of the group, averaged over the cameras that saw the ball long enough
+		costs.clear();
+		for (int controller = 0; controller < count; controller++) {
+			uint8_t code = tracking::blinkCode(controller);
+			for (tracking::TrackedObject* ball : group) {
+				size_t o = std::find(trackedObjects.begin(), trackedObjects.end(), ball) - trackedObjects.begin();
+
+				float correlation = 0.f;
+				int views = 0;
+				for (int i = 0; i < cameraCount; i++) {
+					const tracking::BlinkDecoder& decoder = blinkDecoders[i][o];
+					if (decoder.GetDurationUs() < static_cast<int64_t>(tracking::BLINK_CODE_BITS + 1) * tracking::BLINK_STEP_MS * 1000) continue;
+
+					correlation += decoder.Match(code);
+					views++;
+				}
+				costs.push_back(views > 0 ? 1.f - correlation / views : 2.f);
+			}
+		}
+		tracking::solveGatedAssignment(costs, count, count, 1.f - MIN_BLINK_CORRELATION, assignment);
+
+		std::string colorName = "";
+		for (std::string& serial : connectedControllers) {
+			Controller* controller = controllers->GetController(serial);
+			if (controller->GetTrackedObject() == group[0]) colorName = controller->GetColorName();
+		}
+		if (std::find(assignment.begin(), assignment.end(), -1) != assignment.end()) {
+			logging::warning("The %s controllers couldn't be identified by their blink codes, they are only told apart by their positions", colorName.c_str());
+			continue;
+		}
+
+		// every controller takes over the optical state of the ball that carried its code, its filter starts over from that ball
+		states.clear();
+		for (tracking::TrackedObject* ball : group) {
+			states.push_back({ ball->perCameraData, ball->triangulatedPosition, ball->acquired3DPosition, ball->worldPosition, ball->previousWorldPosition, ball->previousMonocularPosition, ball->opticalVelocity });
+		}
+
+		int swapped = 0;
+		for (int controller = 0; controller < count; controller++) {
+			if (assignment[controller] == controller) continue;
+
+			const OpticalState& state = states[assignment[controller]];
+			tracking::TrackedObject* obj = group[controller];
+			obj->perCameraData = state.perCameraData;
+			obj->triangulatedPosition = state.triangulatedPosition;
+			obj->acquired3DPosition = state.acquired3DPosition;
+			obj->worldPosition = state.worldPosition;
+			obj->previousWorldPosition = state.previousWorldPosition;
+			obj->previousMonocularPosition = state.previousMonocularPosition;
+			obj->opticalVelocity = state.opticalVelocity;
+			// the filter's position is still the old ball's, without a fix in this generation there is nothing to predict the roi from
+			obj->timeSinceOpticalFix = std::numeric_limits<float>::infinity();
+			obj->anchorUncertainty = 1e4f;
+			swapped++;
+		}
+		logging::info("Identified the %zu %s controllers by their blink codes, %d of them had another one's ball", group.size(), colorName.c_str(), swapped);
+	}
+
+	// the controllers light up steadily again
+	for (std::string& serial : connectedControllers) {
+		controllers->GetController(serial)->ClearBlinkCode();
+	}
+	identifyControllers = false;
+}
+
+bool taurus::OpticalThread::EstimateMonocularPosition(tracking::TrackedObject* obj, const tracking::TriangulationPoint& point) {
+	// the largest ball of the views has the most precise radius
+	const tracking::ViewObservation* best = nullptr;
+	float bestRadius = 0.f;
+	for (size_t i = 0; i < point.viewCount; i++) {
+		float radius = obj->perCameraData[point.views[i].camera].circleRadius;
+		if (radius > bestRadius) {
+			bestRadius = radius;
+			best = &point.views[i];
+		}
+	}
+	if (best == nullptr) return false;
+
+	return tracking::estimateMonocularPosition(triangulationCameras[best->camera], *best, bestRadius, obj->triangulatedPosition, obj->positionUncertainty);
+}
+
+void taurus::OpticalThread::PredictRois(float secPassed) {
+	for (tracking::TrackedObject* obj : trackedObjects) {
+		if (obj->acquired3DPosition) obj->timeSinceOpticalFix = 0.f;
+		else obj->timeSinceOpticalFix += secPassed;
+
+		for (tracking::TrackedObject::PerCameraData& data : obj->perCameraData) {
+			data.hasPrediction = false;
+		}
+
+		// after a while the 3D state is too far off to be useful, the detector falls back to its own search
+		if (obj->timeSinceOpticalFix > ROI_PREDICTION_TIMEOUT) continue;
+
+		// fresh optical data, or the filter's position with the IMU kinematics since the last fix
+		glm::vec3 position = obj->acquired3DPosition ? obj->worldPosition : obj->preFilteredPosition;
+		glm::vec3 velocity = obj->acquired3DPosition ? obj->opticalVelocity : obj->kinematic.GetVelocity();
+
+		// where the ball will be in the next generation, assuming it takes as long as this one
+		glm::vec3 predicted = position + velocity * secPassed;
+		float uncertainty = BASE_POSITION_UNCERTAINTY + glm::length(velocity) * secPassed * VELOCITY_UNCERTAINTY_GAIN + obj->timeSinceOpticalFix * LOST_UNCERTAINTY_GROWTH;
+		if (obj->acquired3DPosition && obj->monocularPosition) uncertainty += obj->positionUncertainty;
+
+		for (int i = 0; i < cameraCount; i++) {
+			tracking::TrackedObject::PerCameraData& data = obj->perCameraData[i];
+			if (tracking::predictRoi(projections[i], predicted, uncertainty, data.roi)) {
+				data.roiPredicted = true;
 			}
+
+			float depth;
+			data.hasPrediction = tracking::projectWorldPoint(projections[i], predicted, data.predictedCenter, depth);
 		}
 	}
 }
@@ -36,7 +36,23 @@ void taurus::TaurusApp::Init() {
 		configStorage->rightControllerSerial.value(),
 	};
 	controllers = new ControllerManager(expectedControllers);
-	controllers->ConnectControllers();
+
+	// a replayed session stands in for the controllers and the cameras
+	sessionRecorder = new SessionRecorder();
+	sessionReplayer = new SessionReplayer();
+	bool replaying = false;
+	if (configStorage->replaySession.has_value()) {
+		replaying = sessionReplayer->Open(configStorage->replaySession.value());
+		sessionReplayer->SetRealtime(configStorage->replayRealtime.value_or(true));
+	}
+
+	if (replaying) {
+		controllers->ConnectReplayControllers(sessionReplayer->GetControllerSerials());
+		sessionReplayer->Start(controllers);
+	}
+	else {
+		controllers->ConnectControllers();
+	}
 	connectedControllers = controllers->GetConnectedSerials();
 
 	controllers->GetController(expectedControllers[0])->SetColor(configStorage->leftControllerColor.value());
@@ -44,13 +60,29 @@ void taurus::TaurusApp::Init() {
 
 	// Initialize cameras
 	cameraManager = new CameraManager();
-	cameraManager->SetupCameras();
+	// raw frames skip the full frame color conversion, the detector only demosaics around the balls
+	FrameFormat frameFormat = configStorage->bayerDetection.value_or(false) ? Frame_BAYER : Frame_BGR;
+	if (replaying) {
+		cameraManager->SetupReplayCameras(sessionReplayer);
+	}
+	else if (configStorage->cameraSource.value_or("ps3eye") == "synthetic") {
+		// rendered cameras, with a ball in every controller's color
+		std::shared_ptr<SyntheticScene> scene = std::make_shared<SyntheticScene>();
+		for (std::string color : { configStorage->leftControllerColor.value(), configStorage->rightControllerColor.value() }) {
+			RGB_char rgb = RGB_fromName(color);
+			scene->AddScriptedBall(color, syntheticLedColor(rgb.r, rgb.g, rgb.b));
+		}
+		cameraManager->SetupSyntheticCameras(scene, configStorage->syntheticCameraCount.value_or(2), 640, 480, Exposure_AUTO, frameFormat);
+	}
+	else {
+		cameraManager->SetupCameras(640, 480, 60, Exposure_AUTO, frameFormat);
+	}
 	cameraCount = cameraManager->GetCameraCount();
 
+	for (int i = 0; i < cameraManager->GetCameraCount(); i++) {
+		cameraManager->GetCamera(i).SetExposureMode(Exposure_DARK);
+	}
 	Camera& camera0 = cameraManager->GetCamera(0);
-	camera0.SetExposureMode(Exposure_DARK);
-	Camera& camera1 = cameraManager->GetCamera(1);
-	camera1.SetExposureMode(Exposure_DARK);
 
 	frame = camera0.InitFrameMat();
 
@@ -59,6 +91,10 @@ void taurus::TaurusApp::Init() {
 	filterThread = new FilterThread();
 	commsThread = new CommunicationThread();
 
+	if (configStorage->recordSession.has_value()) {
+		sessionRecorder->Start(configStorage->recordSession.value(), configStorage->recordFrames.value_or(true));
+	}
+
 	logging::info("TaurusApp init finished");
 }
 
@@ -69,10 +105,12 @@ void taurus::TaurusApp::Stop() {
 
 	sock::CleanupComms();
 
+	sessionReplayer->Stop();
 	controllers->StopUpdateThreads();
 	controllers->DisconnectControllers();
 
 	cameraManager->Stop();
+	sessionRecorder->Stop();
 }
 
 void taurus::TaurusApp::MainLoop() {
@@ -0,0 +1,123 @@
+#include "benchmark/center_benchmark.h"
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "benchmark/benchmark_utils.h"
+#include "core/tracking/blob_labeling.h"
+#include "core/tracking/detector.h"
+#include "core/tracking/segmentation.h"
+#include "core/tracking/subpixel.h"
+#include "core/tracking/synthetic.h"
+#include "core/logging.h"
+
+// a rendered ball, with everything the estimators need already prepared
+struct CenterSample {
+	cv::Mat frame;
+	cv::Mat classes;
+	cv::Mat mask;
+	taurus::tracking::BlobStats blob;
+
+	cv::Point2f trueCenter;
+	float trueRadius;
+};
+
+// accuracy of one estimator over all samples
+struct CenterErrors {
+	double meanError = 0.0;
+	double maxError = 0.0;
+	double meanRadiusError = 0.0;
+};
+
+// private helper function
+// renders balls at random subpixel centers, clipped ones are partially outside of the frame
+static std::vector<CenterSample> renderSamples(int count, bool clipped, cv::RNG& rng) {
+	constexpr int FRAME_SIZE = 96;
+	cv::Scalar ballColor = cv::Scalar(230, 230, 20);
+	std::vector<taurus::tracking::HsvColorRange> colors = { taurus::tracking::hsvRangeFromBgr(ballColor) };
+
+	std::vector<CenterSample> samples;
+	std::vector<taurus::tracking::BlobStats> blobs;
+	while (samples.size() < static_cast<size_t>(count)) {
+		CenterSample sample;
+		sample.trueRadius = rng.uniform(5.f, 25.f);
+
+		float half = FRAME_SIZE / 2.f;
+		sample.trueCenter = cv::Point2f(half + rng.uniform(-2.f, 2.f), half + rng.uniform(-2.f, 2.f));
+		if (clipped) {
+			// between a third and two thirds of the ball stays visible
+			sample.trueCenter.x = rng.uniform(-sample.trueRadius / 3.f, sample.trueRadius / 3.f);
+		}
+
+		sample.frame = cv::Mat(FRAME_SIZE, FRAME_SIZE, CV_8UC3);
+		taurus::tracking::renderDarkBackground(sample.frame, rng);
+		taurus::tracking::renderGlowingBall(sample.frame, sample.trueCenter, sample.trueRadius, ballColor);
+
+		taurus::tracking::classifyRoi(sample.frame, taurus::tracking::createFrameRoi(sample.frame), colors, sample.classes);
+		taurus::tracking::labelBlobs(sample.classes, blobs, 8);
+		if (blobs.empty()) continue;
+
+		sample.blob = *std::max_element(blobs.begin(), blobs.end(), [](const auto& a, const auto& b) { return a.area < b.area; });
+		cv::compare(sample.classes, 0, sample.mask, cv::CMP_GT);
+
+		samples.push_back(sample);
+	}
+
+	return samples;
+}
+
+// private helper function
+static CenterErrors measureErrors(const std::vector<cv::Point2f>& centers, const std::vector<float>& radii, const std::vector<CenterSample>& samples) {
+	CenterErrors errors;
+	for (size_t i = 0; i < samples.size(); i++) {
+		double error = cv::norm(centers[i] - samples[i].trueCenter);
+
+		errors.meanError += error;
+		errors.maxError = std::max(errors.maxError, error);
+		errors.meanRadiusError += std::abs(radii[i] - samples[i].trueRadius);
+	}
+
+	errors.meanError /= samples.size();
+	errors.meanRadiusError /= samples.size();
+	return errors;
+}
+
+// private helper function
+static void benchmarkSamples(const char* title, const std::vector<CenterSample>& samples, int iterations) {
+	taurus::logging::info("%s (%d balls):", title, samples.size());
+	int sampleCount = static_cast<int>(samples.size());
+	std::vector<cv::Point2f> centers = std::vector<cv::Point2f>(samples.size());
+	std::vector<float> radii = std::vector<float>(samples.size());
+
+	// old detector, minimum enclosing circle of the largest contour
+	auto contourCircle = [&](int i) {
+		const CenterSample& sample = samples[i % sampleCount];
+		taurus::tracking::findLargestBlob(sample.mask, centers[i % sampleCount], radii[i % sampleCount]);
+	};
+	double contourNs = taurus::benchmark::measureAverageNs(iterations * sampleCount, contourCircle);
+	CenterErrors contourErrors = measureErrors(centers, radii, samples);
+	taurus::logging::info("  %-12s %9.1f ns/blob, center error mean %.4f px, max %.4f px, radius error %.3f px", "contour", contourNs, contourErrors.meanError, contourErrors.maxError, contourErrors.meanRadiusError);
+
+	for (taurus::tracking::CenterEstimator estimator : { taurus::tracking::Center_BLOB_CENTROID, taurus::tracking::Center_INTENSITY_CENTROID, taurus::tracking::Center_CIRCLE_FIT }) {
+		double ns = taurus::benchmark::measureAverageNs(iterations * sampleCount, [&](int i) {
+			const CenterSample& sample = samples[i % sampleCount];
+			taurus::tracking::estimateBallCenter(sample.frame, sample.classes, cv::Point(0, 0), sample.blob, estimator, centers[i % sampleCount], radii[i % sampleCount]);
+		});
+
+		CenterErrors errors = measureErrors(centers, radii, samples);
+		taurus::logging::info("  %-12s %9.1f ns/blob, center error mean %.4f px, max %.4f px, radius error %.3f px", taurus::tracking::centerEstimatorName(estimator), ns, errors.meanError, errors.maxError, errors.meanRadiusError);
+	}
+}
+
+void taurus::benchmark::runCenterBenchmark(int iterations) {
+	logging::info("Center estimation benchmark, %d iterations", iterations);
+
+	constexpr int SAMPLE_COUNT = 64;
+	cv::RNG rng = cv::RNG(4321);
+
+	std::vector<CenterSample> freeSamples = renderSamples(SAMPLE_COUNT, false, rng);
+	benchmarkSamples("Fully visible", freeSamples, iterations);
+
+	std::vector<CenterSample> clippedSamples = renderSamples(SAMPLE_COUNT, true, rng);
+	benchmarkSamples("Clipped by the frame edge", clippedSamples, iterations);
+}
@@ -0,0 +1,163 @@
+#include "benchmark/pipeline_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "core/cameras.h"
+#include "core/psmove.h"
+#include "core/synthetic_source.h"
+#include "core/tracking/detector.h"
+#include "core/tracking/motion_gate.h"
+#include "core/tracking/multiview.h"
+#include "core/tracking/time_alignment.h"
+#include "core/tracking/tracking_utils.h"
+#include "core/logging.h"
+
+// led colors the balls get, in this order
+static const std::vector<std::string> BALL_COLOR_NAMES = { "cyan", "purple", "yellow", "green", "red", "blue" };
+
+void taurus::benchmark::runPipelineBenchmark(int cameraCount, int ballCount, int frameCount, int fps, bool bayer) {
+	ballCount = std::clamp(ballCount, 1, static_cast<int>(BALL_COLOR_NAMES.size()));
+	cameraCount = std::max(cameraCount, 1);
+	logging::info("Pipeline benchmark, %d synthetic cameras, %d balls, %d frames at %d fps, %s frames", cameraCount, ballCount, frameCount, fps, bayer ? "bayer" : "BGR");
+
+	// scripted controllers
+	std::shared_ptr<SyntheticScene> scene = std::make_shared<SyntheticScene>(static_cast<uint16_t>(fps));
+	std::vector<std::string> colorNames;
+	for (int b = 0; b < ballCount; b++) {
+		RGB_char rgb = RGB_fromName(BALL_COLOR_NAMES[b]);
+		scene->AddScriptedBall(BALL_COLOR_NAMES[b], syntheticLedColor(rgb.r, rgb.g, rgb.b));
+		colorNames.push_back(BALL_COLOR_NAMES[b]);
+	}
+
+	CameraManager cameraManager;
+	cameraManager.SetupSyntheticCameras(scene, cameraCount, 640, 480, Exposure_DARK, bayer ? Frame_BAYER : Frame_BGR);
+
+	// the same per-camera setup the optical thread does
+	std::vector<tracking::TrackedObject> objects = std::vector<tracking::TrackedObject>(ballCount);
+	std::vector<tracking::DetectorOptions> detectorOptions;
+	std::vector<CameraCalibration> calibrations;
+	std::vector<tracking::TriangulationCamera> triangulationCameras;
+	std::vector<SyntheticView> views;
+	for (int i = 0; i < cameraCount; i++) {
+		Camera& cam = cameraManager.GetCamera(i);
+		cam.SetTrackedColors(colorNames);
+
+		tracking::DetectorOptions options;
+		options.colorLut = &cam.GetColorLut();
+		options.centerEstimator = cam.GetCenterEstimator();
+		options.bayerPattern = cam.GetBayerPattern();
+		detectorOptions.push_back(options);
+
+		calibrations.push_back(cam.GetCalibration());
+		triangulationCameras.push_back(tracking::createTriangulationCamera(calibrations[i].P, calibrations[i].T, cam.GetUndistortionGrid()));
+		views.push_back(createSyntheticView(calibrations[i], calibrations[0].world, cam.InitFrameMat().size()));
+
+		for (int b = 0; b < ballCount; b++) {
+			tracking::TrackedObject::PerCameraData data;
+			data.color = cam.GetHsvColorRange(colorNames[b]);
+			data.roi = tracking::createFrameRoi(cam.InitFrameMat());
+			objects[b].perCameraData.push_back(data);
+		}
+	}
+
+	std::vector<FrameCursor> cursors = std::vector<FrameCursor>(cameraCount);
+	std::vector<FrameView> frames = std::vector<FrameView>(cameraCount);
+	std::vector<tracking::ViewObservation> triangulationViews;
+	std::vector<tracking::TriangulationPoint> triangulationPoints = std::vector<tracking::TriangulationPoint>(ballCount);
+
+	double detectNs = 0.0;
+	int visible = 0;
+	int detected = 0;
+	int reused = 0;
+	int incremental = 0;
+	int falseDetections = 0;
+	double error2D = 0.0;
+	int triangulated = 0;
+	double error3D = 0.0;
+	double residual = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int f = 0; f < frameCount; f++) {
+		for (int i = 0; i < cameraCount; i++) {
+			if (!cameraManager.GetCamera(i).WaitFrame(cursors[i], frames[i])) break;
+
+			auto detectStart = std::chrono::steady_clock::now();
+			tracking::findMultiBalls(frames[i].frame, objects, i, detectorOptions[i]);
+			detectNs += static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - detectStart).count());
+
+			// compare to where the renderer put the balls
+			cv::Rect frameRect = tracking::createFrameRoi(frames[i].frame);
+			for (int b = 0; b < ballCount; b++) {
+				tracking::TrackedObject::PerCameraData& data = objects[b].perCameraData[i];
+
+				cv::Point2f trueCenter;
+				float trueRadius;
+				bool isVisible = projectSyntheticBall(views[i], scene->GetBallPosition(b, frames[i].timestampUs), trueCenter, trueRadius) && frameRect.contains(trueCenter);
+
+				if (isVisible) visible++;
+				if (isVisible && data.acquiredTracking) {
+					detected++;
+					if (data.reusedDetection) reused++;
+					if (data.incrementalDetection) incremental++;
+					error2D += cv::norm(data.globalCircleCenter - trueCenter);
+				}
+				if (!isVisible && data.acquiredTracking) falseDetections++;
+			}
+		}
+
+		// every camera triangulates, like the optical thread, with the views moved to the time of cam 0's frame
+		if (frames[0].IsValid()) {
+			for (int b = 0; b < ballCount; b++) {
+				triangulationViews.clear();
+				for (int i = 0; i < cameraCount; i++) {
+					tracking::TrackedObject::PerCameraData& data = objects[b].perCameraData[i];
+					if (!frames[i].IsValid()) continue;
+
+					tracking::updateImageMotion(data, tracking::rowTimestampUs(frames[i].timestampUs, cameraManager.GetCamera(i).GetRowTiming(), data.globalCircleCenter.y));
+					if (!data.acquiredTracking || !triangulationCameras[i].valid) continue;
+
+					triangulationViews.push_back(tracking::createViewObservation(i, data, cameraManager.GetCamera(i).GetUndistortionGrid(), frames[0].timestampUs));
+				}
+				tracking::selectTriangulationViews(triangulationCameras, triangulationViews);
+				triangulationPoints[b].SetViews(triangulationViews);
+			}
+
+			tracking::triangulateBatch(triangulationCameras, triangulationPoints);
+			for (int b = 0; b < ballCount; b++) {
+				if (!triangulationPoints[b].valid) continue;
+
+				glm::vec3 worldPosition = tracking::cvPoint3fToGlmVec3(tracking::transform(calibrations[0].world, triangulationPoints[b].position));
+				error3D += glm::length(worldPosition - scene->GetBallPosition(b, frames[0].timestampUs));
+				residual += triangulationPoints[b].residual;
+				triangulated++;
+			}
+		}
+
+		for (FrameView& frame : frames) {
+			frame.Release();
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t missed = 0;
+	for (FrameCursor& cursor : cursors) {
+		missed += cursor.droppedFrames;
+	}
+	cameraManager.Stop();
+
+	double detectUsPerFrame = detectNs / 1000.0 / (static_cast<double>(frameCount) * cameraCount);
+	double framePeriodUs = 1000000.0 / fps;
+	logging::info("Detection:     %.1f us/frame per camera, %.1f%% of the frame period for all cameras", detectUsPerFrame, 100.0 * detectUsPerFrame * cameraCount / framePeriodUs);
+	logging::info("Throughput:    %.1f generations/s, %llu camera frames missed", frameCount / seconds, missed);
+	logging::info("Detected:      %.2f%% of the visible balls, %d false detections", visible > 0 ? 100.0 * detected / visible : 0.0, falseDetections);
+	logging::info("Reused:        %.2f%% of the detections, balls at rest (%s motion gate)", detected > 0 ? 100.0 * reused / detected : 0.0, tracking::motionGateKernelName());
+	logging::info("Incremental:   %.2f%% of the detections, mean-shift tracked", detected > 0 ? 100.0 * incremental / detected : 0.0);
+	logging::info("2D error:      %.3f px", detected > 0 ? error2D / detected : 0.0);
+	logging::info("3D error:      %.3f cm (%d triangulations)", triangulated > 0 ? error3D / triangulated : 0.0, triangulated);
+	logging::info("Reprojection:  %.3f px RMS residual", triangulated > 0 ? residual / triangulated : 0.0);
+}
@@ -0,0 +1,222 @@
+#include "benchmark/segmentation_benchmark.h"
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "benchmark/benchmark_utils.h"
+#include "core/tracking/bayer.h"
+#include "core/tracking/color_lut.h"
+#include "core/tracking/detector.h"
+#include "core/tracking/region_planner.h"
+#include "core/tracking/segmentation.h"
+#include "core/tracking/synthetic.h"
+#include "core/logging.h"
+
+void taurus::benchmark::runSegmentationBenchmark(int iterations) {
+	logging::info("Segmentation benchmark, kernel: %s, %d iterations", tracking::segmentationKernelName(), iterations);
+
+	// two controllers, cyan and purple, as the camera sees them (slightly darker than the led color)
+	std::vector<cv::Scalar> ballColors = {
+		cv::Scalar(230, 230, 20),
+		cv::Scalar(230, 20, 230),
+	};
+	std::vector<tracking::HsvColorRange> colorRanges;
+	for (cv::Scalar& color : ballColors) {
+		colorRanges.push_back(tracking::hsvRangeFromBgr(color));
+	}
+
+	// render a few different frames, so we're not measuring a single cached frame
+	constexpr int FRAME_COUNT = 8;
+	cv::RNG rng = cv::RNG(1234);
+	std::vector<cv::Mat> frames;
+	std::vector<std::vector<cv::Rect>> rois;
+	for (int f = 0; f < FRAME_COUNT; f++) {
+		cv::Mat frame = cv::Mat(480, 640, CV_8UC3);
+		tracking::renderDarkBackground(frame, rng);
+		tracking::renderStaticLight(frame, cv::Rect(520, 40, 60, 90));
+
+		std::vector<cv::Rect> frameRois;
+		for (cv::Scalar& color : ballColors) {
+			cv::Point2f center = cv::Point2f(rng.uniform(80.f, 560.f), rng.uniform(80.f, 400.f));
+			tracking::renderGlowingBall(frame, center, rng.uniform(8.f, 25.f), color);
+
+			cv::Rect roi = tracking::fitNewRoi(center);
+			tracking::clampRoi(frame, roi);
+			frameRois.push_back(roi);
+		}
+
+		frames.push_back(frame);
+		rois.push_back(frameRois);
+	}
+
+	// old chain: full frame bright mask, full frame hsv conversion, inRange per controller roi
+	cv::Mat maskedFrame, mask, hsvMaskedFrame;
+	std::vector<cv::Mat> oldMasks = std::vector<cv::Mat>(ballColors.size());
+	double oldNs = measureAverageNs(iterations, [&](int i) {
+		const cv::Mat& frame = frames[i % FRAME_COUNT];
+		tracking::maskBrightBlobs(frame, maskedFrame, mask);
+		cv::cvtColor(maskedFrame, hsvMaskedFrame, cv::COLOR_BGR2HSV);
+
+		for (size_t c = 0; c < ballColors.size(); c++) {
+			cv::inRange(hsvMaskedFrame(rois[i % FRAME_COUNT][c]), colorRanges[c].lower, colorRanges[c].upper, oldMasks[c]);
+		}
+	});
+
+	// fused kernel, only inside the rois
+	std::vector<cv::Mat> newMasks = std::vector<cv::Mat>(ballColors.size());
+	double newNs = measureAverageNs(iterations, [&](int i) {
+		const cv::Mat& frame = frames[i % FRAME_COUNT];
+
+		for (size_t c = 0; c < ballColors.size(); c++) {
+			tracking::segmentRoi(frame, rois[i % FRAME_COUNT][c], colorRanges[c], newMasks[c]);
+		}
+	});
+
+	// region planner, overlapping rois merged and every color tested in a single pass per region
+	std::vector<tracking::SegmentRegion> regions;
+	std::vector<tracking::HsvColorRange> regionColors;
+	std::vector<cv::Mat> regionMasks;
+	double plannedNs = measureAverageNs(iterations, [&](int i) {
+		const cv::Mat& frame = frames[i % FRAME_COUNT];
+		tracking::planRegions(frame, rois[i % FRAME_COUNT], false, regions);
+
+		for (tracking::SegmentRegion& region : regions) {
+			regionColors.clear();
+			for (size_t member : region.members) {
+				regionColors.push_back(colorRanges[member]);
+			}
+			tracking::segmentRoi(frame, region.bounds, regionColors, regionMasks);
+		}
+	});
+
+	// color lookup table instead of the hsv conversion, same planned regions
+	tracking::ColorLut colorLut;
+	colorLut.Build(colorRanges);
+	cv::Mat hsvClasses, lutClasses, classDifference;
+	double lutNs = measureAverageNs(iterations, [&](int i) {
+		const cv::Mat& frame = frames[i % FRAME_COUNT];
+		tracking::planRegions(frame, rois[i % FRAME_COUNT], false, regions);
+
+		for (tracking::SegmentRegion& region : regions) {
+			tracking::classifyRoi(frame, region.bounds, colorLut, lutClasses);
+		}
+	});
+
+	// how many classified pixels the table gets the same as the exact hsv test
+	size_t lutAgreeing = 0;
+	size_t lutTotal = 0;
+	for (int f = 0; f < FRAME_COUNT; f++) {
+		for (cv::Rect& roi : rois[f]) {
+			tracking::classifyRoi(frames[f], roi, colorRanges, hsvClasses);
+			tracking::classifyRoi(frames[f], roi, colorLut, lutClasses);
+
+			cv::compare(hsvClasses, lutClasses, classDifference, cv::CMP_NE);
+			lutAgreeing += roi.area() - cv::countNonZero(classDifference);
+			lutTotal += roi.area();
+		}
+	}
+
+	// reacquiring every lost controller, whole frame at full resolution against the coarse to fine search
+	std::vector<tracking::TrackedObject> lostObjects = std::vector<tracking::TrackedObject>(ballColors.size());
+	for (size_t c = 0; c < ballColors.size(); c++) {
+		lostObjects[c].perCameraData.resize(1);
+		lostObjects[c].perCameraData[0].color = colorRanges[c];
+	}
+	int reacquired = 0;
+	auto reacquireAll = [&](int i, const tracking::DetectorOptions& options) {
+		for (tracking::TrackedObject& obj : lostObjects) {
+			obj.perCameraData[0].acquiredTracking = false;
+		}
+		tracking::findMultiBalls(frames[i % FRAME_COUNT], lostObjects, 0, options);
+		for (tracking::TrackedObject& obj : lostObjects) {
+			if (obj.perCameraData[0].acquiredTracking) reacquired++;
+		}
+	};
+
+	tracking::DetectorOptions fullSearch;
+	fullSearch.reacquireScale = 1;
+	double fullSearchNs = measureAverageNs(iterations, [&](int i) { reacquireAll(i, fullSearch); });
+	int fullReacquired = reacquired;
+
+	reacquired = 0;
+	tracking::DetectorOptions coarseSearch;
+	double coarseSearchNs = measureAverageNs(iterations, [&](int i) { reacquireAll(i, coarseSearch); });
+	int coarseReacquired = reacquired;
+
+	// raw bayer input, a full frame demosaic before tracking against gating on the mosaic and demosaicing only around the bright spots
+	std::vector<cv::Mat> bayerFrames = std::vector<cv::Mat>(FRAME_COUNT);
+	for (int f = 0; f < FRAME_COUNT; f++) {
+		tracking::mosaicBgr(frames[f], tracking::PS3EYE_BAYER_PATTERN, bayerFrames[f]);
+	}
+	std::vector<tracking::TrackedObject> trackedObjects = std::vector<tracking::TrackedObject>(ballColors.size());
+	for (size_t c = 0; c < ballColors.size(); c++) {
+		trackedObjects[c].perCameraData.resize(1);
+		trackedObjects[c].perCameraData[0].color = colorRanges[c];
+	}
+	int tracked = 0;
+	auto trackAll = [&](int i, const cv::Mat& frame) {
+		for (size_t c = 0; c < ballColors.size(); c++) {
+			trackedObjects[c].perCameraData[0].roi = rois[i % FRAME_COUNT][c];
+			trackedObjects[c].perCameraData[0].acquiredTracking = true;
+		}
+		tracking::findMultiBalls(frame, trackedObjects, 0);
+		for (tracking::TrackedObject& obj : trackedObjects) {
+			if (obj.perCameraData[0].acquiredTracking) tracked++;
+		}
+	};
+
+	cv::Mat demosaicedFrame;
+	double fullDemosaicNs = measureAverageNs(iterations, [&](int i) {
+		tracking::demosaicFrame(bayerFrames[i % FRAME_COUNT], tracking::PS3EYE_BAYER_PATTERN, demosaicedFrame);
+		trackAll(i, demosaicedFrame);
+	});
+	int fullDemosaicTracked = tracked;
+
+	tracked = 0;
+	double bayerNs = measureAverageNs(iterations, [&](int i) { trackAll(i, bayerFrames[i % FRAME_COUNT]); });
+	int bayerTracked = tracked;
+
+	// pixel work of the planned regions compared to the whole frame
+	size_t plannedPixels = 0;
+	for (int f = 0; f < FRAME_COUNT; f++) {
+		tracking::planRegions(frames[f], rois[f], false, regions);
+		plannedPixels += tracking::regionPixelCount(regions);
+	}
+	double wholeFramePixels = static_cast<double>(frames[0].total()) * FRAME_COUNT;
+
+	// check that both produce (almost) the same masks on every frame
+	double iouSum = 0.0;
+	int iouCount = 0;
+	for (int f = 0; f < FRAME_COUNT; f++) {
+		tracking::maskBrightBlobs(frames[f], maskedFrame, mask);
+		cv::cvtColor(maskedFrame, hsvMaskedFrame, cv::COLOR_BGR2HSV);
+
+		for (size_t c = 0; c < ballColors.size(); c++) {
+			cv::inRange(hsvMaskedFrame(rois[f][c]), colorRanges[c].lower, colorRanges[c].upper, oldMasks[c]);
+			tracking::segmentRoi(frames[f], rois[f][c], colorRanges[c], newMasks[c]);
+
+			cv::Mat intersection, combined;
+			cv::bitwise_and(oldMasks[c], newMasks[c], intersection);
+			cv::bitwise_or(oldMasks[c], newMasks[c], combined);
+
+			int combinedCount = cv::countNonZero(combined);
+			if (combinedCount > 0) {
+				iouSum += static_cast<double>(cv::countNonZero(intersection)) / combinedCount;
+				iouCount++;
+			}
+		}
+	}
+
+	logging::info("Old chain:     %.1f us/frame", oldNs / 1000.0);
+	logging::info("Fused kernel:  %.1f us/frame", newNs / 1000.0);
+	logging::info("Planned:       %.1f us/frame", plannedNs / 1000.0);
+	logging::info("Lookup table:  %.1f us/frame", lutNs / 1000.0);
+	logging::info("Speedup:       %.2fx (planned %.2fx, lookup table %.2fx)", oldNs / newNs, oldNs / plannedNs, oldNs / lutNs);
+	logging::info("Table agrees:  %.2f%% of the roi pixels", 100.0 * lutAgreeing / lutTotal);
+	logging::info("Pixel work:    %.1f%% of the whole frame", 100.0 * plannedPixels / wholeFramePixels);
+	logging::info("Mask IoU:      %.4f", iouCount > 0 ? iouSum / iouCount : 0.0);
+	logging::info("Reacquire:     %.1f us/frame full frame, %.1f us/frame coarse to fine (%dx), %.2fx", fullSearchNs / 1000.0, coarseSearchNs / 1000.0, coarseSearch.reacquireScale, fullSearchNs / coarseSearchNs);
+	logging::info("Reacquired:    %d full frame, %d coarse to fine, of %d", fullReacquired, coarseReacquired, iterations * static_cast<int>(ballColors.size()));
+	logging::info("Bayer:         %.1f us/frame full demosaic, %.1f us/frame demosaic around bright spots, %.2fx", fullDemosaicNs / 1000.0, bayerNs / 1000.0, fullDemosaicNs / bayerNs);
+	logging::info("Bayer tracked: %d full demosaic, %d bright spots, of %d", fullDemosaicTracked, bayerTracked, iterations * static_cast<int>(ballColors.size()));
+}
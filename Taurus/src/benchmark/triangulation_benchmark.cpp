@@ -0,0 +1,224 @@
+#include "benchmark/triangulation_benchmark.h"
+
+#include <algorithm>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "benchmark/benchmark_utils.h"
+#include "core/cameras.h"
+#include "core/synthetic_source.h"
+#include "core/tracking/multiview.h"
+#include "core/tracking/undistortion.h"
+#include "core/tracking/tracking_utils.h"
+#include "core/logging.h"
+
+// cameras of the generated rig, the two view cases use the first two
+static constexpr int RIG_CAMERA_COUNT = 4;
+// controllers triangulated together, like a full play area
+static constexpr int BATCH_SIZE = 4;
+// cm around the stage center the points are spread over
+static constexpr float STAGE_SPREAD = 40.f;
+// standard deviation of the detected centers, pixels
+static constexpr float PIXEL_NOISE = 0.3f;
+// radial distortion of a lens with about the PS3 Eye's barrel distortion, for the undistortion lookup
+static constexpr double LENS_K1 = -0.12;
+static constexpr double LENS_K2 = 0.08;
+
+// a point with its noisy pixel position in every camera of the rig
+struct TriangulationSample {
+	cv::Point3f truePosition;
+	std::vector<cv::Point2f> pixels;
+};
+
+// accuracy of one method over all samples
+struct TriangulationErrors {
+	double meanError = 0.0;
+	double maxError = 0.0;
+	double meanResidual = 0.0;
+	int failed = 0;
+};
+
+// private helper function
+// the triangulation the optical thread did before the kernel, with its static scratch buffers
+static cv::Point3f triangulateReference(const cv::Mat& P0, const cv::Mat& P1, const cv::Point2f& point0, const cv::Point2f& point1) {
+	static cv::Mat points0 = cv::Mat(2, 1, CV_64FC1);
+	static cv::Mat points1 = cv::Mat(2, 1, CV_64FC1);
+
+	points0.at<double>(0, 0) = static_cast<double>(point0.x);
+	points0.at<double>(1, 0) = static_cast<double>(point0.y);
+	points1.at<double>(0, 0) = static_cast<double>(point1.x);
+	points1.at<double>(1, 0) = static_cast<double>(point1.y);
+
+	static cv::Mat homogeneous = cv::Mat(4, 1, CV_64FC1);
+	cv::triangulatePoints(P0, P1, points0, points1, homogeneous);
+
+	double w = homogeneous.at<double>(3, 0);
+	float x = static_cast<float>(homogeneous.at<double>(0, 0) / w);
+	float y = static_cast<float>(homogeneous.at<double>(1, 0) / w);
+	float z = static_cast<float>(homogeneous.at<double>(2, 0) / w);
+	return cv::Point3f(x, y, z);
+}
+
+// private helper function
+// pixel position of a point, returns false if it's behind the camera
+static bool projectPoint(const cv::Matx34d& P, const cv::Point3f& position, cv::Point2f& pixel) {
+	cv::Vec3d projected = P * cv::Vec4d(position.x, position.y, position.z, 1.0);
+	if (projected[2] <= 0.0) return false;
+
+	pixel = cv::Point2f(static_cast<float>(projected[0] / projected[2]), static_cast<float>(projected[1] / projected[2]));
+	return true;
+}
+
+// private helper function
+static std::vector<TriangulationSample> createSamples(int count, const std::vector<taurus::tracking::TriangulationCamera>& cameras, const cv::Point3f& stageCenter, cv::RNG& rng) {
+	std::vector<TriangulationSample> samples;
+	while (samples.size() < static_cast<size_t>(count)) {
+		TriangulationSample sample;
+		sample.truePosition = stageCenter + cv::Point3f(rng.uniform(-STAGE_SPREAD, STAGE_SPREAD), rng.uniform(-STAGE_SPREAD, STAGE_SPREAD), rng.uniform(-STAGE_SPREAD, STAGE_SPREAD));
+
+		bool inFront = true;
+		for (const taurus::tracking::TriangulationCamera& camera : cameras) {
+			cv::Point2f pixel;
+			inFront = inFront && projectPoint(camera.P, sample.truePosition, pixel);
+			sample.pixels.push_back(pixel + cv::Point2f(static_cast<float>(rng.gaussian(PIXEL_NOISE)), static_cast<float>(rng.gaussian(PIXEL_NOISE))));
+		}
+		if (inFront) samples.push_back(sample);
+	}
+
+	return samples;
+}
+
+// private helper function
+// the points of a sample as the kernel takes them, from its first viewCount cameras
+static taurus::tracking::TriangulationPoint createPoint(const TriangulationSample& sample, int viewCount) {
+	taurus::tracking::TriangulationPoint point;
+	point.viewCount = static_cast<size_t>(viewCount);
+	for (int i = 0; i < viewCount; i++) {
+		point.views[i].camera = i;
+		point.views[i].point = sample.pixels[i];
+	}
+	return point;
+}
+
+// private helper function
+static void addError(TriangulationErrors& errors, const cv::Point3f& position, const cv::Point3f& truePosition, float residual) {
+	double error = cv::norm(position - truePosition);
+	errors.meanError += error;
+	errors.maxError = std::max(errors.maxError, error);
+	errors.meanResidual += residual;
+}
+
+// private helper function
+static void logErrors(const char* name, double ns, TriangulationErrors errors, int sampleCount) {
+	int solved = std::max(sampleCount - errors.failed, 1);
+	taurus::logging::info("  %-22s %8.1f ns/point, error mean %.4f cm, max %.4f cm, residual %.3f px, %d failed", name, ns, errors.meanError / solved, errors.maxError, errors.meanResidual / solved, errors.failed);
+}
+
+// private helper function
+// the grid lookup against solving the distortion model per point, over the whole frame
+static void benchmarkUndistortion(const cv::Mat& K, int iterations, cv::RNG& rng) {
+	constexpr int POINT_COUNT = 256;
+	cv::Size frameSize = cv::Size(640, 480);
+
+	std::vector<cv::Point2f> pixels;
+	for (int i = 0; i < POINT_COUNT; i++) {
+		pixels.push_back(cv::Point2f(rng.uniform(0.f, static_cast<float>(frameSize.width)), rng.uniform(0.f, static_cast<float>(frameSize.height))));
+	}
+
+	cv::Mat distort = cv::Mat::zeros(1, 5, CV_64F);
+	distort.at<double>(0, 0) = LENS_K1;
+	distort.at<double>(0, 1) = LENS_K2;
+
+	taurus::tracking::UndistortionGrid grid;
+	double buildNs = taurus::benchmark::measureAverageNs(1, [&](int i) {
+		grid.Build(K, distort, frameSize);
+	});
+
+	std::vector<cv::Point2f> single = std::vector<cv::Point2f>(1);
+	std::vector<cv::Point2f> solved = std::vector<cv::Point2f>(1);
+	std::vector<cv::Point2f> exact = std::vector<cv::Point2f>(POINT_COUNT);
+	double solveNs = taurus::benchmark::measureAverageNs(iterations * POINT_COUNT / 16, [&](int i) {
+		single[0] = pixels[i % POINT_COUNT];
+		cv::undistortPoints(single, solved, K, distort);
+		exact[i % POINT_COUNT] = solved[0];
+	});
+
+	std::vector<cv::Point2f> looked = std::vector<cv::Point2f>(POINT_COUNT);
+	double lookupNs = taurus::benchmark::measureAverageNs(iterations * POINT_COUNT, [&](int i) {
+		looked[i % POINT_COUNT] = grid.Lookup(pixels[i % POINT_COUNT]);
+	});
+
+	double maxError = 0.0;
+	for (int i = 0; i < POINT_COUNT; i++) {
+		maxError = std::max(maxError, cv::norm(looked[i] - exact[i]) * grid.GetFocalLength());
+	}
+
+	taurus::logging::info("Undistortion (grid built in %.2f ms):", buildNs / 1000000.0);
+	taurus::logging::info("  %-22s %8.1f ns/point", "cv::undistortPoints", solveNs);
+	taurus::logging::info("  %-22s %8.1f ns/point, max %.4f px from cv::undistortPoints", "grid lookup", lookupNs, maxError);
+}
+
+void taurus::benchmark::runTriangulationBenchmark(int iterations) {
+	logging::info("Triangulation benchmark, %d iterations, %.1f px noise", iterations, PIXEL_NOISE);
+
+	constexpr int SAMPLE_COUNT = 256;
+	cv::RNG rng = cv::RNG(2468);
+
+	// a generated rig, in the frames the extrinsic calibrator writes
+	std::vector<CameraCalibration> calibrations = std::vector<CameraCalibration>(RIG_CAMERA_COUNT);
+	completeSyntheticCalibrations(calibrations, cv::Size(640, 480));
+	std::vector<tracking::TriangulationCamera> cameras;
+	for (CameraCalibration& calib : calibrations) {
+		cameras.push_back(tracking::createTriangulationCamera(calib.P));
+	}
+
+	cv::Point3f stageCenter = tracking::transform(calibrations[0].world.inv(), tracking::glmVec3ToCvPoint3f(syntheticStageCenter(calibrations)));
+	std::vector<TriangulationSample> samples = createSamples(SAMPLE_COUNT, cameras, stageCenter, rng);
+	std::vector<cv::Point3f> positions = std::vector<cv::Point3f>(samples.size());
+
+	// old path, two views through cv::triangulatePoints
+	double referenceNs = measureAverageNs(iterations * SAMPLE_COUNT, [&](int i) {
+		const TriangulationSample& sample = samples[i % SAMPLE_COUNT];
+		positions[i % SAMPLE_COUNT] = triangulateReference(calibrations[0].P, calibrations[1].P, sample.pixels[0], sample.pixels[1]);
+	});
+	TriangulationErrors referenceErrors;
+	for (int s = 0; s < SAMPLE_COUNT; s++) {
+		addError(referenceErrors, positions[s], samples[s].truePosition, 0.f);
+	}
+	logErrors("cv::triangulatePoints", referenceNs, referenceErrors, SAMPLE_COUNT);
+
+	// the kernel, one point per call and batched, with two views and the whole rig
+	for (int viewCount : { 2, RIG_CAMERA_COUNT }) {
+		std::vector<tracking::TriangulationPoint> points;
+		for (const TriangulationSample& sample : samples) {
+			points.push_back(createPoint(sample, viewCount));
+		}
+
+		double singleNs = measureAverageNs(iterations * SAMPLE_COUNT, [&](int i) {
+			tracking::triangulatePoint(cameras, points[i % SAMPLE_COUNT]);
+		});
+
+		// the batches are the same points, BATCH_SIZE at a time
+		std::vector<std::vector<tracking::TriangulationPoint>> batches = std::vector<std::vector<tracking::TriangulationPoint>>(SAMPLE_COUNT / BATCH_SIZE);
+		for (int s = 0; s < SAMPLE_COUNT; s++) {
+			batches[s / BATCH_SIZE].push_back(points[s]);
+		}
+		int batchCount = static_cast<int>(batches.size());
+		double batchNs = measureAverageNs(iterations * batchCount, [&](int i) {
+			tracking::triangulateBatch(cameras, batches[i % batchCount]);
+		}) / BATCH_SIZE;
+
+		TriangulationErrors errors;
+		for (int s = 0; s < SAMPLE_COUNT; s++) {
+			const tracking::TriangulationPoint& point = batches[s / BATCH_SIZE][s % BATCH_SIZE];
+			if (point.valid) addError(errors, point.position, samples[s].truePosition, point.residual);
+			else errors.failed++;
+		}
+
+		logging::info("%d views:", viewCount);
+		logErrors("kernel, single", singleNs, errors, SAMPLE_COUNT);
+		logErrors("kernel, batched", batchNs, errors, SAMPLE_COUNT);
+	}
+
+	benchmarkUndistortion(calibrations[0].K, iterations, rng);
+}
@@ -0,0 +1,67 @@
+#include "core/camera_source.h"
+
+#include "core/frame_ring.h"
+
+// the OV7725 reads a fixed number of rows per frame in each resolution (the active ones plus blanking), the frame rate only changes its pixel clock
+static constexpr int OV7725_VGA_FRAME_ROWS = 510;
+static constexpr int OV7725_QVGA_FRAME_ROWS = 278;
+
+taurus::PS3EyeSource::PS3EyeSource(ps3eye::PS3EYECam::PS3EYERef ps3eyeRef) {
+	this->ps3eyeRef = ps3eyeRef;
+}
+
+const char* taurus::PS3EyeSource::GetName() const {
+	return "PS3 Eye";
+}
+
+void taurus::PS3EyeSource::Start(int width, int height, uint16_t fps) {
+	ps3eye::PS3EYECam::EOutputFormat outputFormat = frameFormat == Frame_BAYER ? ps3eye::PS3EYECam::EOutputFormat::Bayer : ps3eye::PS3EYECam::EOutputFormat::BGR;
+	ps3eyeRef->init(width, height, fps, outputFormat);
+	ps3eyeRef->start();
+}
+
+void taurus::PS3EyeSource::Stop() {
+	ps3eyeRef->stop();
+}
+
+int taurus::PS3EyeSource::GetWidth() const {
+	return ps3eyeRef->getWidth();
+}
+
+int taurus::PS3EyeSource::GetHeight() const {
+	return ps3eyeRef->getHeight();
+}
+
+void taurus::PS3EyeSource::SetExposureMode(ExposureMode mode) {
+	if (mode == Exposure_AUTO) {
+		ps3eyeRef->setAutogain(true);
+		ps3eyeRef->setExposure(120);
+	} else if (mode == Exposure_DARK) {
+		ps3eyeRef->setAutogain(false);
+		ps3eyeRef->setGain(0);
+		ps3eyeRef->setExposure(10);
+	}
+}
+
+bool taurus::PS3EyeSource::SetFrameFormat(FrameFormat format) {
+	frameFormat = format;
+	return true;
+}
+
+taurus::FrameFormat taurus::PS3EyeSource::GetFrameFormat() const {
+	return frameFormat;
+}
+
+int64_t taurus::PS3EyeSource::GetRowReadoutNs() const {
+	int64_t fps = ps3eyeRef->getFrameRate();
+	if (fps <= 0) return 0;
+
+	int64_t frameRows = GetHeight() > 240 ? OV7725_VGA_FRAME_ROWS : OV7725_QVGA_FRAME_ROWS;
+	return 1000000000 / (fps * frameRows);
+}
+
+void taurus::PS3EyeSource::GrabFrame(uint8_t* data, int64_t& timestampUs) {
+	// getFrame blocks until the next frame has arrived, that's the closest we get to its capture time
+	ps3eyeRef->getFrame(data);
+	timestampUs = captureClockUs();
+}
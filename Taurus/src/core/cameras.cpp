@@ -1,14 +1,22 @@
 #include "core/cameras.h"
 
+#include "core/synthetic_source.h"
+#include "core/session_recorder.h"
+#include "core/session_replayer.h"
+#include "core/tracking/synthetic.h"
 #include "core/logging.h"
 #include "core/json_handler.h"
 
-taurus::Camera::Camera(uint8_t id, ps3eye::PS3EYECam::PS3EYERef ps3eyeRef, int width, int height, uint16_t fps, ExposureMode exposureMode) {
-	this->ps3eyeRef = ps3eyeRef;
+taurus::Camera::Camera(uint8_t id, std::unique_ptr<CameraSource> source, int width, int height, uint16_t fps, ExposureMode exposureMode, FrameFormat frameFormat) {
+	this->source = std::move(source);
 	this->id = id;
+
+	if (!this->source->SetFrameFormat(frameFormat)) {
+		logging::warning("Cam %d: %s source can't deliver the requested frame format, using its own", id, this->source->GetName());
+	}
+	this->frameFormat = this->source->GetFrameFormat();
 	
-	ps3eyeRef->init(width, height, fps);
-	ps3eyeRef->start();
+	this->source->Start(width, height, fps);
 
 	this->width = width;
 	this->height = height;
@@ -17,6 +25,39 @@ taurus::Camera::Camera(uint8_t id, ps3eye::PS3EYECam::PS3EYERef ps3eyeRef, int w
 	SetExposureMode(exposureMode);
 
 	LoadData();
+
+	int frameType = this->frameFormat == Frame_BAYER ? CV_8UC1 : CV_8UC3;
+	frameRing = std::make_unique<FrameRing>(this->source->GetWidth(), this->source->GetHeight(), frameType);
+	frameRing->SetBlocking(this->source->IsConsumerPaced());
+}
+
+taurus::Camera::~Camera() {
+	Stop();
+}
+
+void taurus::Camera::StartCapture() {
+	if (isStarted) return;
+
+	// consumers only ever read from the ring
+	captureActive.store(true);
+	captureThread = std::thread(&Camera::CaptureThreadFunc, this);
+	isStarted = true;
+}
+
+void taurus::Camera::CaptureThreadFunc() {
+	while (captureActive.load()) {
+		cv::Mat& buffer = frameRing->BeginWrite();
+		int64_t timestampUs;
+		source->GrabFrame(buffer.data, timestampUs);
+
+		// recorded before it's published, the producer owns the buffer until then
+		SessionRecorder* recorder = SessionRecorder::GetInstance();
+		if (recorder != nullptr && recorder->IsRecording()) {
+			recorder->RecordFrame(id, timestampUs, buffer);
+		}
+
+		frameRing->EndWrite(timestampUs);
+	}
 }
 
 void taurus::Camera::LoadData() {
@@ -45,6 +86,7 @@ void taurus::Camera::LoadData() {
 	else {
 		logging::warning("Color calibration could not be loaded, this may cause issues!");
 	}
+	RebuildColorLut();
 
 	// load intrinsic
 	data = json();
@@ -82,25 +124,63 @@ void taurus::Camera::LoadData() {
 	// create P matrix
 	if (calibration.hasIntrinsic && calibration.hasExtrinsic) {
 		calibration.P = calibration.K * calibration.T;
+		calibration.hasProjection = true;
 		logging::info("Successfully created projection matrix P");
 	}
+	RebuildUndistortionGrid();
+}
+
+void taurus::Camera::RebuildUndistortionGrid() {
+	if (!calibration.hasIntrinsic) {
+		undistortionGrid.Clear();
+		return;
+	}
+
+	undistortionGrid.Build(calibration.K, calibration.distort, cv::Size(source->GetWidth(), source->GetHeight()));
 }
 
 void taurus::Camera::SetExposureMode(ExposureMode mode) {
 	exposureMode = mode;
+	source->SetExposureMode(mode);
+}
 
-	if (mode == Exposure_AUTO) {
-		ps3eyeRef->setAutogain(true);
-		ps3eyeRef->setExposure(120);
-	} else if (mode == Exposure_DARK) {
-		ps3eyeRef->setAutogain(false);
-		ps3eyeRef->setGain(0);
-		ps3eyeRef->setExposure(10);
-	}
+bool taurus::Camera::WaitFrame(FrameCursor& cursor, FrameView& view) {
+	return frameRing->WaitNext(cursor, view);
+}
+
+bool taurus::Camera::GetLatestFrame(FrameView& view) {
+	return frameRing->TryGetLatest(view);
+}
+
+uint64_t taurus::Camera::GetOverrunCount() const {
+	return frameRing->GetOverrunCount();
 }
 
 void taurus::Camera::GetFrame(cv::Mat& frame) {
-	ps3eyeRef->getFrame(frame.data);
+	FrameView view;
+	if (WaitFrame(copyCursor, view)) {
+		if (frameFormat == Frame_BAYER) {
+			tracking::demosaicFrame(view.frame, source->GetBayerPattern(), frame);
+		}
+		else {
+			view.frame.copyTo(frame);
+		}
+	}
+}
+
+taurus::FrameFormat taurus::Camera::GetFrameFormat() const {
+	return frameFormat;
+}
+
+taurus::tracking::BayerPattern taurus::Camera::GetBayerPattern() const {
+	return source->GetBayerPattern();
+}
+
+taurus::tracking::RowTiming taurus::Camera::GetRowTiming() const {
+	tracking::RowTiming timing;
+	timing.rowReadoutNs = source->GetRowReadoutNs();
+	timing.rows = source->GetHeight();
+	return timing;
 }
 
 uint8_t taurus::Camera::GetID() const {
@@ -124,13 +204,73 @@ taurus::CameraCalibration taurus::Camera::GetCalibration() const {
 	return calibration;
 }
 
+void taurus::Camera::SetCalibration(const CameraCalibration& calibration) {
+	this->calibration = calibration;
+	RebuildColorLut();
+	RebuildUndistortionGrid();
+}
+
+const taurus::tracking::UndistortionGrid& taurus::Camera::GetUndistortionGrid() const {
+	return undistortionGrid;
+}
+
+const char* taurus::Camera::GetSourceName() const {
+	return source->GetName();
+}
+
+void taurus::Camera::SetTrackedColors(const std::vector<std::string>& colorNames) {
+	if (colorNames == trackedColors && colorLut.IsBuilt()) return;
+
+	trackedColors = colorNames;
+	RebuildColorLut();
+}
+
+const taurus::tracking::ColorLut& taurus::Camera::GetColorLut() const {
+	return colorLut;
+}
+
+void taurus::Camera::SetCenterEstimator(tracking::CenterEstimator estimator) {
+	centerEstimator = estimator;
+}
+
+taurus::tracking::CenterEstimator taurus::Camera::GetCenterEstimator() const {
+	return centerEstimator;
+}
+
+void taurus::Camera::RebuildColorLut() {
+	// the table can only be built when every tracked color is calibrated
+	bool canBuild = calibration.hasColor && !trackedColors.empty() && trackedColors.size() <= tracking::MAX_SEGMENT_COLORS;
+	std::vector<tracking::HsvColorRange> colors;
+	for (std::string& name : trackedColors) {
+		canBuild = canBuild && calibration.colorDict.contains(name);
+		if (canBuild) colors.push_back(calibration.colorDict[name]);
+	}
+
+	if (!canBuild) {
+		colorLut.Clear();
+		return;
+	}
+
+	// built with the lowest gate the adaptive thresholds go to, higher ones are tested on top of it
+	colorLut.Build(colors, tracking::MIN_BRIGHT_THRESHOLD);
+	logging::info("Built color lookup table for cam %d (%zu colors)", id, colors.size());
+}
+
 cv::Mat taurus::Camera::InitFrameMat() {
 
-	return cv::Mat(ps3eyeRef->getHeight(), ps3eyeRef->getWidth(), CV_8UC3);
+	return cv::Mat(source->GetHeight(), source->GetWidth(), CV_8UC3);
 }
 
 void taurus::Camera::Stop() {
-	ps3eyeRef->stop();
+	if (!isStarted) return;
+	isStarted = false;
+
+	// every waiting consumer gets woken up (and a blocking ring's producer), then the capture thread finishes its current frame
+	captureActive.store(false);
+	frameRing->Close();
+	if (captureThread.joinable()) captureThread.join();
+
+	source->Stop();
 }
 
 taurus::CameraManager* taurus::CameraManager::instance = nullptr;
@@ -149,35 +289,92 @@ taurus::CameraManager::CameraManager() {
 	logging::info("Found %d PS3 Eye cameras.", ps3eyeCount);
 }
 
-void taurus::CameraManager::SetupCameras(int width, int height, uint16_t fps, taurus::ExposureMode exposureMode) {
+void taurus::CameraManager::SetupCameras(int width, int height, uint16_t fps, taurus::ExposureMode exposureMode, taurus::FrameFormat frameFormat) {
 	// init all the cameras
 	for (uint8_t i = 0; i < ps3eyeCount; i++) {
 		logging::info("Setting up camera %d ...", i);
 
 		ps3eye::PS3EYECam::PS3EYERef eye = ps3eyeReferences[i];
 
-		Camera camera = Camera(i, eye, width, height, fps, exposureMode);
-		cameras.push_back(camera);
+		// cameras own their capture thread, so they stay at the same address
+		cameras.push_back(std::make_unique<Camera>(i, std::make_unique<PS3EyeSource>(eye), width, height, fps, exposureMode, frameFormat));
+	}
+
+	for (std::unique_ptr<Camera>& camera : cameras) {
+		camera->StartCapture();
+	}
+}
+
+void taurus::CameraManager::SetupSyntheticCameras(std::shared_ptr<SyntheticScene> scene, int cameraCount, int width, int height, taurus::ExposureMode exposureMode, taurus::FrameFormat frameFormat) {
+	std::vector<SyntheticCameraSource*> sources;
+	for (int i = 0; i < cameraCount; i++) {
+		logging::info("Setting up synthetic camera %d ...", i);
+
+		std::unique_ptr<SyntheticCameraSource> source = std::make_unique<SyntheticCameraSource>(scene, static_cast<uint32_t>(1234 + i));
+		sources.push_back(source.get());
+		cameras.push_back(std::make_unique<Camera>(static_cast<uint8_t>(i), std::move(source), width, height, scene->GetFps(), exposureMode, frameFormat));
+	}
+
+	// real calibrations where they exist, the rest of the rig gets generated
+	std::vector<CameraCalibration> calibrations;
+	for (std::unique_ptr<Camera>& camera : cameras) {
+		calibrations.push_back(camera->GetCalibration());
+	}
+	completeSyntheticCalibrations(calibrations, cv::Size(width, height));
+
+	for (int i = 0; i < cameraCount; i++) {
+		// the renderer decides what color the balls are, so the color calibration has to come from it too
+		CameraCalibration& calib = calibrations[i];
+		for (size_t b = 0; b < scene->GetBallCount(); b++) {
+			const SyntheticBall& ball = scene->GetBall(b);
+			calib.colorDict[ball.colorName] = tracking::hsvRangeFromBgr(ball.color);
+		}
+		calib.hasColor = true;
+
+		cameras[i]->SetCalibration(calib);
+		sources[i]->SetView(createSyntheticView(calib, calibrations[0].world, cv::Size(width, height)));
+	}
+
+	scene->SetStageCenter(syntheticStageCenter(calibrations));
+	scene->Restart();
+	for (std::unique_ptr<Camera>& camera : cameras) {
+		camera->StartCapture();
+	}
+
+	logging::info("Set up %d synthetic cameras rendering %d balls", cameraCount, scene->GetBallCount());
+}
+
+void taurus::CameraManager::SetupReplayCameras(SessionReplayer* replayer) {
+	for (size_t i = 0; i < replayer->GetCameraCount(); i++) {
+		logging::info("Setting up replayed camera %d ...", i);
+
+		// calibrations are loaded from the files, like for the cameras that were recorded, the frame format is whatever was recorded
+		std::unique_ptr<ReplayCameraSource> source = std::make_unique<ReplayCameraSource>(replayer, static_cast<uint8_t>(i));
+		FrameFormat frameFormat = source->GetFrameFormat();
+		cameras.push_back(std::make_unique<Camera>(static_cast<uint8_t>(i), std::move(source), 640, 480, 60, Exposure_AUTO, frameFormat));
+	}
+
+	for (std::unique_ptr<Camera>& camera : cameras) {
+		camera->StartCapture();
 	}
 }
 
 size_t taurus::CameraManager::GetCameraCount() const {
-	return ps3eyeCount;
+	return cameras.size();
 }
 
 taurus::Camera& taurus::CameraManager::GetCamera(uint8_t id) {
-	return cameras[id];
+	return *cameras[id];
 }
 
 void taurus::CameraManager::GetFrame(uint8_t id, cv::Mat& frame) {
-	cameras[id].GetFrame(frame);
+	cameras[id]->GetFrame(frame);
 }
 
 void taurus::CameraManager::Stop() {
 	logging::info("Stopping camera manager...");
 
-	for (uint8_t i = 0; i < ps3eyeCount; i++) {
-		Camera camera = cameras[i];
-		camera.Stop();
+	for (std::unique_ptr<Camera>& camera : cameras) {
+		camera->Stop();
 	}
 }
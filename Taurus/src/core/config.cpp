@@ -74,6 +74,16 @@ void taurus::TaurusConfig::ParseConfig() {
 	storage.annotatePreview = tryGetJsonValue<bool>(configData, "annotate_preview");
 	storage.lowpassAlpha = tryGetJsonValue<float>(configData, "lowpass_alpha");
 	storage.lowpassDistance = tryGetJsonValue<float>(configData, "lowpass_distance");
+	storage.centerEstimators = tryGetJsonValue<std::vector<std::string>>(configData, "center_estimators");
+	storage.cameraSource = tryGetJsonValue<std::string>(configData, "camera_source");
+	storage.syntheticCameraCount = tryGetJsonValue<int>(configData, "synthetic_camera_count");
+	storage.bayerDetection = tryGetJsonValue<bool>(configData, "bayer_detection");
+	storage.staticLightSuppression = tryGetJsonValue<bool>(configData, "static_light_suppression");
+	storage.blinkIdentification = tryGetJsonValue<bool>(configData, "blink_identification");
+	storage.recordSession = tryGetJsonValue<std::string>(configData, "record_session");
+	storage.recordFrames = tryGetJsonValue<bool>(configData, "record_frames");
+	storage.replaySession = tryGetJsonValue<std::string>(configData, "replay_session");
+	storage.replayRealtime = tryGetJsonValue<bool>(configData, "replay_realtime");
 
 	logging::info("Successfully parsed config file.");
 }
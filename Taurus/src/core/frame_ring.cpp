@@ -0,0 +1,203 @@
+#include "core/frame_ring.h"
+
+#include <chrono>
+#include <limits>
+
+int64_t taurus::captureClockUs() {
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+taurus::FrameView::FrameView(FrameView&& other) noexcept {
+	*this = std::move(other);
+}
+
+taurus::FrameView& taurus::FrameView::operator=(FrameView&& other) noexcept {
+	if (this == &other) return *this;
+
+	Release();
+	frame = other.frame;
+	sequence = other.sequence;
+	timestampUs = other.timestampUs;
+	ring = other.ring;
+	slot = other.slot;
+	consumes = other.consumes;
+
+	other.frame = cv::Mat();
+	other.ring = nullptr;
+	other.slot = -1;
+	other.consumes = false;
+	return *this;
+}
+
+taurus::FrameView::~FrameView() {
+	Release();
+}
+
+void taurus::FrameView::Release() {
+	if (ring != nullptr) {
+		ring->Unpin(slot);
+		if (consumes) ring->Consume(sequence);
+	}
+
+	frame = cv::Mat();
+	ring = nullptr;
+	slot = -1;
+	consumes = false;
+}
+
+bool taurus::FrameView::IsValid() const {
+	return ring != nullptr;
+}
+
+taurus::FrameRing::FrameRing(int width, int height, int type) {
+	for (Slot& slot : slots) {
+		slot.frame = cv::Mat(height, width, type);
+	}
+	scratch = cv::Mat(height, width, type);
+}
+
+void taurus::FrameRing::SetBlocking(bool blocking) {
+	this->blocking = blocking;
+}
+
+cv::Mat& taurus::FrameRing::BeginWrite() {
+	// a blocking ring doesn't capture the next frame before the pacing reader is done with the newest one
+	if (blocking) {
+		uint64_t seen = consumed.load(std::memory_order_acquire);
+		while (seen < lastPublished && !closed.load(std::memory_order_acquire)) {
+			consumed.wait(seen, std::memory_order_acquire);
+			seen = consumed.load(std::memory_order_acquire);
+		}
+	}
+
+	int latestSlot = static_cast<int>(published.load(std::memory_order_acquire) & SLOT_MASK);
+
+	// claim any slot no view holds, except the newest frame, which readers may be about to pin
+	for (int i = 0; i < SLOT_COUNT; i++) {
+		if (i == latestSlot) continue;
+
+		int expected = 0;
+		if (slots[i].pins.compare_exchange_strong(expected, -1, std::memory_order_acquire)) {
+			writeSlot = i;
+			return slots[i].frame;
+		}
+	}
+
+	// every slot is held by a view, the producer can't wait for them, so this frame is lost
+	writeSlot = -1;
+	return scratch;
+}
+
+void taurus::FrameRing::EndWrite(int64_t timestampUs) {
+	// dropped frames still use up a sequence number, so readers can tell that they missed one
+	uint64_t sequence = nextSequence++;
+	if (writeSlot == -1) {
+		overruns.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Slot& slot = slots[writeSlot];
+	slot.sequence = sequence;
+	slot.timestampUs = timestampUs;
+	slot.pins.store(0, std::memory_order_release);
+
+	published.store((sequence << SLOT_BITS) | static_cast<uint64_t>(writeSlot), std::memory_order_release);
+	published.notify_all();
+	writeSlot = -1;
+	lastPublished = sequence;
+}
+
+bool taurus::FrameRing::WaitNext(FrameCursor& cursor, FrameView& view) {
+	view.Release();
+
+	while (true) {
+		uint64_t current = published.load(std::memory_order_acquire);
+		if (closed.load(std::memory_order_acquire)) return false;
+
+		uint64_t slot = current & SLOT_MASK;
+		uint64_t sequence = current >> SLOT_BITS;
+		if (slot == NO_SLOT || sequence <= cursor.lastSequence) {
+			published.wait(current, std::memory_order_acquire);
+			continue;
+		}
+
+		// the producer may have claimed the slot since it was published, a newer frame is on its way then
+		if (!Pin(static_cast<int>(slot), view)) continue;
+		if (view.sequence <= cursor.lastSequence) {
+			view.Release();
+			continue;
+		}
+
+		if (cursor.lastSequence != 0) {
+			cursor.droppedFrames += view.sequence - cursor.lastSequence - 1;
+		}
+		cursor.lastSequence = view.sequence;
+		view.consumes = blocking && cursor.pacesProducer;
+		return true;
+	}
+}
+
+bool taurus::FrameRing::TryGetLatest(FrameView& view) {
+	view.Release();
+
+	while (true) {
+		uint64_t slot = published.load(std::memory_order_acquire) & SLOT_MASK;
+		if (slot == NO_SLOT) return false;
+		if (Pin(static_cast<int>(slot), view)) return true;
+	}
+}
+
+void taurus::FrameRing::Close() {
+	closed.store(true, std::memory_order_release);
+
+	// waiting readers only wake up for a changed value, so bump the sequence once more
+	published.fetch_add(uint64_t(1) << SLOT_BITS, std::memory_order_acq_rel);
+	published.notify_all();
+
+	// and a producer waiting for the pacing reader
+	consumed.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+	consumed.notify_all();
+}
+
+bool taurus::FrameRing::IsClosed() const {
+	return closed.load(std::memory_order_acquire);
+}
+
+uint64_t taurus::FrameRing::GetSequence() const {
+	return published.load(std::memory_order_acquire) >> SLOT_BITS;
+}
+
+uint64_t taurus::FrameRing::GetOverrunCount() const {
+	return overruns.load(std::memory_order_relaxed);
+}
+
+bool taurus::FrameRing::Pin(int slot, FrameView& view) {
+	Slot& s = slots[slot];
+
+	int pins = s.pins.load(std::memory_order_acquire);
+	while (pins >= 0) {
+		if (s.pins.compare_exchange_weak(pins, pins + 1, std::memory_order_acquire)) {
+			// a plain header over the slot's pixels, so readers never touch the slot's reference count
+			view.frame = cv::Mat(s.frame.rows, s.frame.cols, s.frame.type(), s.frame.data, s.frame.step);
+			view.sequence = s.sequence;
+			view.timestampUs = s.timestampUs;
+			view.ring = this;
+			view.slot = slot;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void taurus::FrameRing::Unpin(int slot) {
+	slots[slot].pins.fetch_sub(1, std::memory_order_release);
+}
+
+void taurus::FrameRing::Consume(uint64_t sequence) {
+	uint64_t seen = consumed.load(std::memory_order_relaxed);
+	while (seen < sequence && !consumed.compare_exchange_weak(seen, sequence, std::memory_order_release)) {
+	}
+	consumed.notify_all();
+}
@@ -5,6 +5,8 @@
 #include "core/utils.h"
 #include "core/logging.h"
 #include "core/json_handler.h"
+#include "core/session_recorder.h"
+#include "core/tracking/blink_code.h"
 
 // readonly static color map, created at compile-time
 static constexpr std::pair<std::string_view, taurus::RGB_char> colorTable[] = {
@@ -40,6 +42,7 @@ const std::vector<std::string> taurus::RGB_colorNames() {
 taurus::Controller::Controller(std::string serial) {
 	this->serial = serial;
 	this->connected = false;
+	this->moveHandle = nullptr;
 
 	this->colorName = "off";
 	this->color = RGB_OFF;
@@ -96,7 +99,20 @@ void taurus::Controller::Connect(PSMove* move) {
 	moveHandle = move;
 }
 
+void taurus::Controller::ConnectReplay() {
+	connected = true;
+	connectionType = Conn_Unknown;
+	moveHandle = nullptr;
+}
+
+void taurus::Controller::ReplaySample(const ControllerSample& sample) {
+	ProcessSample(sample);
+}
+
 bool taurus::Controller::Update() {
+	// replayed controllers have no device to poll or write to
+	if (moveHandle == nullptr) return false;
+
 	// only poll if connected via bluetooth
 	bool hadNewData = false;
 	if (connectionType != Conn_USB) {
@@ -114,6 +130,21 @@ bool taurus::Controller::Update() {
 		SetColorRaw(color);
 	}
 
+	// blink codes step at the same ticks on every controller, so the step changes are written right away
+	int code = blinkCode.load();
+	if (code >= 0 && now / tracking::BLINK_STEP_MS != blinkStep) {
+		blinkStep = now / tracking::BLINK_STEP_MS;
+
+		float level = tracking::blinkLevel(static_cast<uint8_t>(code), now);
+		psmove_set_leds(moveHandle, static_cast<unsigned char>(color.r * level), static_cast<unsigned char>(color.g * level), static_cast<unsigned char>(color.b * level));
+		controllerWriteUrgent = true;
+	}
+	else if (code < 0 && blinkStep >= 0) {
+		blinkStep = -1;
+		SetColorRaw(color);
+		controllerWriteUrgent = true;
+	}
+
 	// do rubmle stuff
 	HandleRumble(now);
 	
@@ -135,7 +166,9 @@ void taurus::Controller::Disconnect() {
 		StopUpdateThread();
 	}
 
-	psmove_disconnect(moveHandle);
+	if (moveHandle != nullptr) {
+		psmove_disconnect(moveHandle);
+	}
 }
 
 void taurus::Controller::StartUpdateThread() {
@@ -168,6 +201,14 @@ std::string taurus::Controller::GetColorName() {
 	return colorName;
 }
 
+void taurus::Controller::SetBlinkCode(uint8_t code) {
+	blinkCode.store(code);
+}
+
+void taurus::Controller::ClearBlinkCode() {
+	blinkCode.store(-1);
+}
+
 void taurus::Controller::DoRumble(float durationSeconds, float strength) {
 	rumbleState.active = true;
 
@@ -223,15 +264,40 @@ void taurus::Controller::ResetAhrs() {
 }
 
 void taurus::Controller::HandlePoll() {
-	long now = psmove_util_get_ticks();
-	
-	HandleBattery(now);
-	HandleInput(now);
-	HandleAhrs(now);
+	ControllerSample sample;
+	ReadSample(sample);
+
+	SessionRecorder* recorder = SessionRecorder::GetInstance();
+	if (recorder != nullptr && recorder->IsRecording()) {
+		recorder->RecordControllerSample(serial, sample);
+	}
+
+	ProcessSample(sample);
+}
+
+void taurus::Controller::ReadSample(ControllerSample& sample) {
+	sample.timeMs = psmove_util_get_ticks();
+	sample.buttons = psmove_get_buttons(moveHandle);
+	sample.trigger = psmove_get_trigger(moveHandle);
+	sample.battery = psmove_get_battery(moveHandle);
+
+	// the sensor output gives 2 half-frames per poll
+	for (int frameHalf = 0; frameHalf < 2; frameHalf++) {
+		glm::vec3& a = sample.accel[frameHalf];
+		glm::vec3& g = sample.gyro[frameHalf];
+		psmove_get_accelerometer_frame(moveHandle, static_cast<PSMove_Frame>(frameHalf), &a.x, &a.y, &a.z);
+		psmove_get_gyroscope_frame(moveHandle, static_cast<PSMove_Frame>(frameHalf), &g.x, &g.y, &g.z);
+	}
 }
 
-void taurus::Controller::HandleBattery(long now) {
-	batteryState = psmove_get_battery(moveHandle);
+void taurus::Controller::ProcessSample(const ControllerSample& sample) {
+	HandleBattery(sample);
+	HandleInput(sample);
+	HandleAhrs(sample);
+}
+
+void taurus::Controller::HandleBattery(const ControllerSample& sample) {
+	batteryState = static_cast<PSMove_Battery_Level>(sample.battery);
 
 	isCharging = (batteryState == Batt_CHARGING) || (batteryState == Batt_CHARGING_DONE);
 
@@ -268,14 +334,15 @@ void taurus::Controller::HandleBattery(long now) {
 	battery01 = percent / 100.f;
 }
 
-void taurus::Controller::HandleInput(long now) {
-	buttonBitfield = psmove_get_buttons(moveHandle);
+void taurus::Controller::HandleInput(const ControllerSample& sample) {
+	buttonBitfield = sample.buttons;
 
-	trigger = psmove_get_trigger(moveHandle);
+	trigger = static_cast<unsigned char>(sample.trigger);
 	trigger01 = static_cast<float>(trigger) / 255.f;
 }
 
-void taurus::Controller::HandleAhrs(long now) {
+void taurus::Controller::HandleAhrs(const ControllerSample& sample) {
+	long now = static_cast<long>(sample.timeMs);
 	if (ahrsState.lastSample == 0) {
 		// first sample, we have nothing to work with
 		ahrsState.lastSample = now;
@@ -298,8 +365,8 @@ void taurus::Controller::HandleAhrs(long now) {
 	// 2 sensor halves
 	for (int frameHalf = 0; frameHalf < 2; frameHalf++) {
 		// get the accelerometer and gyroscope for the current frame half
-		psmove_get_accelerometer_frame(moveHandle, static_cast<PSMove_Frame>(frameHalf), &aVec.x, &aVec.y, &aVec.z);
-		psmove_get_gyroscope_frame(moveHandle, static_cast<PSMove_Frame>(frameHalf), &gVec.x, &gVec.y, &gVec.z);
+		aVec = sample.accel[frameHalf];
+		gVec = sample.gyro[frameHalf];
 
 		// use the imu calibration to correct the sensor readings
 		if (imuCalibration.hasGyro) {
@@ -341,7 +408,8 @@ void taurus::Controller::HandleRumble(long now) {
 }
 
 void taurus::Controller::UpdateThreadFunction() {
-	if (!connected) return;
+	// replayed controllers are fed by the session replayer instead
+	if (!connected || moveHandle == nullptr) return;
 
 	while (updateThreadRunning.load()) {
 		bool polled = Update();
@@ -423,6 +491,21 @@ void taurus::ControllerManager::ConnectControllers() {
 	}
 }
 
+void taurus::ControllerManager::ConnectReplayControllers(const std::vector<std::string>& serials) {
+	for (const std::string& serial : serials) {
+		if (controllers.find(serial) == controllers.end()) {
+			controllers[serial] = std::make_unique<Controller>(serial);
+			controllers[serial]->LoadData();
+
+			allocatedSerials.push_back(serial);
+		}
+
+		controllers[serial]->ConnectReplay();
+		connectedSerials.push_back(serial);
+		taurus::logging::info("Connected %s (replay)", serial.c_str());
+	}
+}
+
 void taurus::ControllerManager::UpdateControllers() {
 	for (std::string& p : connectedSerials) {
 		controllers[p]->Update();
@@ -0,0 +1,185 @@
+#include "core/session_log.h"
+
+#include <cstring>
+
+#include "core/logging.h"
+
+#if defined( _WIN32 )
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+taurus::SessionLog::~SessionLog() {
+	Close();
+}
+
+bool taurus::SessionLog::Open(const fs::path& path) {
+	Close();
+
+#if defined( _WIN32 )
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		logging::error("Failed to open session %s", path.string().c_str());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	fileHandle = file;
+	size = static_cast<uint64_t>(fileSize.QuadPart);
+
+	if (size > 0) {
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			mappingHandle = mapping;
+			data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		logging::error("Failed to open session %s", path.string().c_str());
+		return false;
+	}
+
+	struct stat fileStat;
+	fstat(file, &fileStat);
+	size = static_cast<uint64_t>(fileStat.st_size);
+
+	if (size > 0) {
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped != MAP_FAILED) {
+			data = static_cast<const uint8_t*>(mapped);
+			madvise(mapped, size, MADV_SEQUENTIAL);
+		}
+	}
+	// the mapping keeps the file alive on its own
+	::close(file);
+#endif
+
+	if (data == nullptr) {
+		logging::error("Failed to map session %s", path.string().c_str());
+		Close();
+		return false;
+	}
+
+	const SessionFileHeader* header = reinterpret_cast<const SessionFileHeader*>(data);
+	if (size < sizeof(SessionFileHeader) || std::memcmp(header->magic, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+		logging::error("%s is not a recorded session", path.string().c_str());
+		Close();
+		return false;
+	}
+	if (header->version != SESSION_VERSION) {
+		logging::error("Session %s has version %u, expected %u", path.string().c_str(), header->version, SESSION_VERSION);
+		Close();
+		return false;
+	}
+
+	if (!ReadIndex()) {
+		logging::warning("Session %s has no index, it was probably not stopped cleanly, scanning the records", path.string().c_str());
+		if (!ScanRecords()) {
+			logging::warning("Session %s is truncated, replaying the %zu complete records", path.string().c_str(), index.size());
+		}
+	}
+
+	return true;
+}
+
+void taurus::SessionLog::Close() {
+#if defined( _WIN32 )
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (mappingHandle != nullptr) CloseHandle(static_cast<HANDLE>(mappingHandle));
+	if (fileHandle != nullptr) CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+	if (data != nullptr) munmap(const_cast<uint8_t*>(data), size);
+#endif
+
+	data = nullptr;
+	size = 0;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	index.clear();
+}
+
+bool taurus::SessionLog::IsOpen() const {
+	return data != nullptr;
+}
+
+int64_t taurus::SessionLog::GetStartTimestampUs() const {
+	return reinterpret_cast<const SessionFileHeader*>(data)->startTimestampUs;
+}
+
+const std::vector<taurus::SessionIndexEntry>& taurus::SessionLog::GetIndex() const {
+	return index;
+}
+
+const taurus::SessionRecordHeader& taurus::SessionLog::GetRecord(const SessionIndexEntry& entry) const {
+	return *reinterpret_cast<const SessionRecordHeader*>(data + entry.offset);
+}
+
+const uint8_t* taurus::SessionLog::GetPayload(const SessionIndexEntry& entry) const {
+	return data + entry.offset + sizeof(SessionRecordHeader);
+}
+
+cv::Mat taurus::SessionLog::GetFrame(const SessionIndexEntry& entry) const {
+	const SessionRecordHeader& record = GetRecord(entry);
+	if (record.type != Record_CAMERA_FRAME || record.size < sizeof(SessionFrameInfo)) return cv::Mat();
+
+	const uint8_t* payload = GetPayload(entry);
+	const SessionFrameInfo* info = reinterpret_cast<const SessionFrameInfo*>(payload);
+
+	// a corrupt header must not make the view reach past its record
+	if (info->width <= 0 || info->height <= 0) return cv::Mat();
+	uint64_t rowBytes = static_cast<uint64_t>(info->width) * CV_ELEM_SIZE(info->type);
+	uint64_t pixelBytes = static_cast<uint64_t>(info->step) * static_cast<uint64_t>(info->height);
+	if (info->step < rowBytes || pixelBytes + sizeof(SessionFrameInfo) > record.size) return cv::Mat();
+
+	uint8_t* pixels = const_cast<uint8_t*>(payload + sizeof(SessionFrameInfo));
+
+	// the mapping is read only, so the returned header must never be written to
+	return cv::Mat(info->height, info->width, info->type, pixels, info->step);
+}
+
+std::string taurus::SessionLog::GetString(const SessionIndexEntry& entry) const {
+	const char* payload = reinterpret_cast<const char*>(GetPayload(entry));
+	return std::string(payload, GetRecord(entry).size);
+}
+
+bool taurus::SessionLog::ReadIndex() {
+	if (size < sizeof(SessionFileHeader) + sizeof(SessionFooter)) return false;
+
+	const SessionFooter* footer = reinterpret_cast<const SessionFooter*>(data + size - sizeof(SessionFooter));
+	if (std::memcmp(footer->magic, SESSION_INDEX_MAGIC, sizeof(SESSION_INDEX_MAGIC)) != 0) return false;
+
+	uint64_t indexBytes = footer->indexCount * sizeof(SessionIndexEntry);
+	if (footer->indexOffset + indexBytes + sizeof(SessionFooter) != size) return false;
+
+	const SessionIndexEntry* entries = reinterpret_cast<const SessionIndexEntry*>(data + footer->indexOffset);
+	index.assign(entries, entries + footer->indexCount);
+	return true;
+}
+
+bool taurus::SessionLog::ScanRecords() {
+	index.clear();
+
+	uint64_t offset = reinterpret_cast<const SessionFileHeader*>(data)->headerSize;
+	while (offset + sizeof(SessionRecordHeader) <= size) {
+		const SessionRecordHeader* record = reinterpret_cast<const SessionRecordHeader*>(data + offset);
+		uint64_t next = offset + sizeof(SessionRecordHeader) + sessionPaddedSize(record->size);
+
+		// a record the writer didn't finish, or garbage after the last record
+		if (record->type < Record_CAMERA_FRAME || record->type > Record_MESSAGE || next > size) return false;
+
+		index.push_back({ offset, record->type, record->stream, record->timestampUs });
+		offset = next;
+	}
+
+	return offset == size;
+}
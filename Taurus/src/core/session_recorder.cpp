@@ -0,0 +1,222 @@
+#include "core/session_recorder.h"
+
+#include <cstring>
+
+#include "core/frame_ring.h"
+#include "core/logging.h"
+
+taurus::SessionRecorder* taurus::SessionRecorder::instance = nullptr;
+
+taurus::SessionRecorder* taurus::SessionRecorder::GetInstance() {
+	return instance;
+}
+
+taurus::SessionRecorder::SessionRecorder() {
+	taurus::SessionRecorder::instance = this;
+}
+
+bool taurus::SessionRecorder::Start(const fs::path& path, bool recordFrames) {
+	// a recording whose writes failed isn't recording anymore, but still has to be closed
+	if (writerThread.joinable()) Stop();
+
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		logging::error("Failed to create session file %s", path.string().c_str());
+		return false;
+	}
+
+	SessionFileHeader header = {};
+	std::memcpy(header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+	header.version = SESSION_VERSION;
+	header.headerSize = sizeof(SessionFileHeader);
+	header.startTimestampUs = captureClockUs();
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!file) {
+		logging::error("Failed to write session file %s", path.string().c_str());
+		file.close();
+		return false;
+	}
+
+	this->recordFrames = recordFrames;
+	fileOffset = sizeof(SessionFileHeader);
+	index.clear();
+	sequences.clear();
+	controllerStreams.clear();
+	queue.clear();
+	queuedBytes = 0;
+	stopWriter = false;
+	writeFailed = false;
+	droppedRecords.store(0);
+
+	writerThread = std::thread(&SessionRecorder::WriterThreadFunc, this);
+	recording.store(true);
+
+	logging::info("Recording session to %s%s", path.string().c_str(), recordFrames ? "" : " (without camera frames)");
+	return true;
+}
+
+void taurus::SessionRecorder::Stop() {
+	recording.store(false);
+	if (!writerThread.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopWriter = true;
+	}
+	queueCondition.notify_one();
+	writerThread.join();
+
+	// the records written before the failure can still be replayed, the replay scans for them without an index
+	if (writeFailed) {
+		file.close();
+		logging::warning("Session recording stopped after a failed write, %zu records written, %llu dropped", index.size(), droppedRecords.load());
+		return;
+	}
+
+	// the index goes after the last record, the footer at the very end points to it
+	SessionFooter footer = {};
+	std::memcpy(footer.magic, SESSION_INDEX_MAGIC, sizeof(SESSION_INDEX_MAGIC));
+	footer.indexOffset = fileOffset;
+	footer.indexCount = index.size();
+
+	file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(SessionIndexEntry));
+	file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+	if (!file) {
+		logging::error("Failed to write the session index, the session has to be scanned when replayed");
+	}
+	file.close();
+
+	logging::info("Session recording stopped, %zu records written, %llu dropped", index.size(), droppedRecords.load());
+}
+
+bool taurus::SessionRecorder::IsRecording() const {
+	return recording.load(std::memory_order_relaxed);
+}
+
+void taurus::SessionRecorder::RecordFrame(uint8_t cameraId, int64_t timestampUs, const cv::Mat& frame) {
+	if (!recordFrames || !IsRecording()) return;
+
+	SessionFrameInfo info = {};
+	info.width = frame.cols;
+	info.height = frame.rows;
+	info.type = frame.type();
+	info.step = static_cast<uint32_t>(frame.cols * frame.elemSize());
+
+	// rows are stored packed, whatever the source's stride is
+	std::vector<uint8_t> payload(sizeof(SessionFrameInfo) + static_cast<size_t>(info.step) * info.height);
+	std::memcpy(payload.data(), &info, sizeof(info));
+	uint8_t* pixels = payload.data() + sizeof(SessionFrameInfo);
+	for (int y = 0; y < frame.rows; y++) {
+		std::memcpy(pixels + static_cast<size_t>(y) * info.step, frame.ptr(y), info.step);
+	}
+
+	Push(Record_CAMERA_FRAME, cameraId, timestampUs, std::move(payload));
+}
+
+void taurus::SessionRecorder::RecordControllerSample(const std::string& serial, const ControllerSample& sample) {
+	if (!IsRecording()) return;
+
+	int64_t timestampUs = captureClockUs();
+
+	uint32_t stream;
+	bool isNew = false;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		auto it = controllerStreams.find(serial);
+		isNew = it == controllerStreams.end();
+		if (isNew) {
+			stream = static_cast<uint32_t>(controllerStreams.size());
+			controllerStreams[serial] = stream;
+		}
+		else {
+			stream = it->second;
+		}
+	}
+
+	// the first time a controller shows up, its serial is recorded, the samples only carry the stream id
+	if (isNew) {
+		Push(Record_CONTROLLER_INFO, stream, timestampUs, std::vector<uint8_t>(serial.begin(), serial.end()));
+	}
+
+	std::vector<uint8_t> payload(sizeof(ControllerSample));
+	std::memcpy(payload.data(), &sample, sizeof(sample));
+	Push(Record_CONTROLLER_SAMPLE, stream, timestampUs, std::move(payload));
+}
+
+void taurus::SessionRecorder::RecordMessage(const void* data, size_t size) {
+	if (!IsRecording()) return;
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	Push(Record_MESSAGE, 0, captureClockUs(), std::vector<uint8_t>(bytes, bytes + size));
+}
+
+uint64_t taurus::SessionRecorder::GetDroppedRecordCount() const {
+	return droppedRecords.load(std::memory_order_relaxed);
+}
+
+void taurus::SessionRecorder::Push(SessionRecordType type, uint32_t stream, int64_t timestampUs, std::vector<uint8_t>&& payload) {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (stopWriter) return;
+
+		// dropping keeps the capture and poll threads at their pace, the replay sees the gap as lost frames
+		if (queuedBytes + payload.size() > MAX_QUEUED_BYTES) {
+			droppedRecords.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		uint64_t sequenceKey = (static_cast<uint64_t>(type) << 32) | stream;
+
+		PendingRecord record;
+		record.header.type = type;
+		record.header.size = static_cast<uint32_t>(payload.size());
+		record.header.stream = stream;
+		record.header.sequence = sequences[sequenceKey]++;
+		record.header.timestampUs = timestampUs;
+		record.payload = std::move(payload);
+
+		queuedBytes += record.payload.size();
+		queue.push_back(std::move(record));
+	}
+	queueCondition.notify_one();
+}
+
+void taurus::SessionRecorder::WriterThreadFunc() {
+	static constexpr char padding[8] = {};
+
+	while (true) {
+		PendingRecord record;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return stopWriter || !queue.empty(); });
+
+			// the queue is drained before stopping, so nothing recorded before Stop is lost
+			if (queue.empty()) return;
+
+			record = std::move(queue.front());
+			queue.pop_front();
+			queuedBytes -= record.payload.size();
+		}
+
+		uint64_t paddedSize = sessionPaddedSize(record.payload.size());
+		file.write(reinterpret_cast<const char*>(&record.header), sizeof(SessionRecordHeader));
+		file.write(reinterpret_cast<const char*>(record.payload.data()), record.payload.size());
+		file.write(padding, paddedSize - record.payload.size());
+
+		// a full disk or a removed drive, every later record would fail the same way
+		if (!file) {
+			logging::error("Failed to write the session file, the recording is stopped");
+			recording.store(false);
+
+			std::lock_guard<std::mutex> lock(queueMutex);
+			writeFailed = true;
+			stopWriter = true;
+			queue.clear();
+			queuedBytes = 0;
+			return;
+		}
+
+		index.push_back({ fileOffset, record.header.type, record.header.stream, record.header.timestampUs });
+		fileOffset += sizeof(SessionRecordHeader) + paddedSize;
+	}
+}
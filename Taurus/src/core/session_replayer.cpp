@@ -0,0 +1,208 @@
+#include "core/session_replayer.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "core/frame_ring.h"
+#include "core/logging.h"
+
+taurus::SessionReplayer* taurus::SessionReplayer::instance = nullptr;
+
+taurus::SessionReplayer* taurus::SessionReplayer::GetInstance() {
+	return instance;
+}
+
+taurus::SessionReplayer::SessionReplayer() {
+	taurus::SessionReplayer::instance = this;
+}
+
+taurus::SessionReplayer::~SessionReplayer() {
+	Stop();
+}
+
+bool taurus::SessionReplayer::Open(const fs::path& path) {
+	if (!log.Open(path)) return false;
+
+	cameraFrames.clear();
+	controllerSerials.clear();
+	controllerSamples.clear();
+
+	// split the index into streams once, the replay threads just walk their own list
+	for (const SessionIndexEntry& entry : log.GetIndex()) {
+		switch (entry.type) {
+			case Record_CAMERA_FRAME:
+				if (entry.stream >= cameraFrames.size()) cameraFrames.resize(entry.stream + 1);
+				cameraFrames[entry.stream].push_back(entry);
+				break;
+			case Record_CONTROLLER_INFO:
+				if (entry.stream >= controllerSerials.size()) controllerSerials.resize(entry.stream + 1);
+				controllerSerials[entry.stream] = log.GetString(entry);
+				break;
+			case Record_CONTROLLER_SAMPLE:
+				controllerSamples.push_back(entry);
+				break;
+			default:
+				break;
+		}
+	}
+
+	logging::info("Opened session %s: %zu cameras, %zu controllers, %zu records", path.string().c_str(), cameraFrames.size(), controllerSerials.size(), log.GetIndex().size());
+	for (size_t i = 0; i < cameraFrames.size(); i++) {
+		logging::info("Session cam %zu: %zu frames", i, cameraFrames[i].size());
+	}
+
+	return true;
+}
+
+void taurus::SessionReplayer::SetRealtime(bool realtime) {
+	this->realtime = realtime;
+}
+
+bool taurus::SessionReplayer::IsRealtime() const {
+	return realtime;
+}
+
+std::vector<std::string> taurus::SessionReplayer::GetControllerSerials() const {
+	return controllerSerials;
+}
+
+size_t taurus::SessionReplayer::GetCameraCount() const {
+	return cameraFrames.size();
+}
+
+const std::vector<taurus::SessionIndexEntry>& taurus::SessionReplayer::GetCameraFrames(uint8_t cameraId) const {
+	return cameraFrames[cameraId];
+}
+
+const taurus::SessionLog& taurus::SessionReplayer::GetLog() const {
+	return log;
+}
+
+void taurus::SessionReplayer::Start(ControllerManager* controllerManager) {
+	if (running.load()) return;
+
+	replayStartUs = captureClockUs();
+	running.store(true);
+	controllersFinished.store(controllerSamples.empty());
+	controllerThread = std::thread(&SessionReplayer::ControllerThreadFunc, this, controllerManager);
+
+	logging::info("Replaying session (%s)", realtime ? "realtime" : "as fast as possible");
+}
+
+void taurus::SessionReplayer::Stop() {
+	if (!running.exchange(false)) return;
+
+	if (controllerThread.joinable()) controllerThread.join();
+}
+
+bool taurus::SessionReplayer::IsFinished() const {
+	return controllersFinished.load();
+}
+
+int64_t taurus::SessionReplayer::ReplayTimeUs(int64_t recordedTimestampUs) const {
+	return replayStartUs + (recordedTimestampUs - log.GetStartTimestampUs());
+}
+
+void taurus::SessionReplayer::WaitUntil(int64_t recordedTimestampUs) const {
+	if (!realtime) return;
+
+	int64_t waitUs = ReplayTimeUs(recordedTimestampUs) - captureClockUs();
+	if (waitUs > 0) {
+		std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+	}
+}
+
+void taurus::SessionReplayer::ControllerThreadFunc(ControllerManager* controllerManager) {
+	for (const SessionIndexEntry& entry : controllerSamples) {
+		if (!running.load()) return;
+
+		WaitUntil(entry.timestampUs);
+
+		if (entry.stream >= controllerSerials.size()) continue;
+		Controller* controller = controllerManager->GetController(controllerSerials[entry.stream]);
+		if (controller == nullptr) continue;
+
+		// the payload may not be aligned for the sample's vectors, so it's copied out
+		ControllerSample sample;
+		std::memcpy(&sample, log.GetPayload(entry), sizeof(sample));
+		controller->ReplaySample(sample);
+	}
+
+	controllersFinished.store(true);
+	logging::info("Session replay: controller samples finished");
+}
+
+taurus::ReplayCameraSource::ReplayCameraSource(SessionReplayer* replayer, uint8_t cameraId) : frames(replayer->GetCameraFrames(cameraId)) {
+	this->replayer = replayer;
+
+	if (!frames.empty()) {
+		cv::Mat first = replayer->GetLog().GetFrame(frames[0]);
+		width = first.cols;
+		height = first.rows;
+		frameFormat = first.type() == CV_8UC1 ? Frame_BAYER : Frame_BGR;
+	}
+}
+
+const char* taurus::ReplayCameraSource::GetName() const {
+	return "Session replay";
+}
+
+void taurus::ReplayCameraSource::Start(int width, int height, uint16_t fps) {
+	nextFrame = 0;
+	finished.store(frames.empty());
+}
+
+void taurus::ReplayCameraSource::Stop() {
+}
+
+int taurus::ReplayCameraSource::GetWidth() const {
+	return width;
+}
+
+int taurus::ReplayCameraSource::GetHeight() const {
+	return height;
+}
+
+void taurus::ReplayCameraSource::SetExposureMode(ExposureMode mode) {
+}
+
+bool taurus::ReplayCameraSource::SetFrameFormat(FrameFormat format) {
+	return format == frameFormat;
+}
+
+taurus::FrameFormat taurus::ReplayCameraSource::GetFrameFormat() const {
+	return frameFormat;
+}
+
+void taurus::ReplayCameraSource::GrabFrame(uint8_t* data, int64_t& timestampUs) {
+	if (nextFrame >= frames.size()) {
+		// nothing new is coming, but the capture thread still has to come back every now and then to be stopped
+		finished.store(true);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if (frames.empty()) {
+			timestampUs = captureClockUs();
+			return;
+		}
+		nextFrame = frames.size() - 1;
+	}
+
+	const SessionIndexEntry& entry = frames[nextFrame];
+	replayer->WaitUntil(entry.timestampUs);
+
+	cv::Mat recorded = replayer->GetLog().GetFrame(entry);
+	cv::Mat target(height, width, frameFormat == Frame_BAYER ? CV_8UC1 : CV_8UC3, data);
+	if (recorded.size() == target.size() && recorded.type() == target.type()) {
+		recorded.copyTo(target);
+	}
+
+	timestampUs = finished.load() ? captureClockUs() : replayer->ReplayTimeUs(entry.timestampUs);
+	nextFrame++;
+}
+
+bool taurus::ReplayCameraSource::IsConsumerPaced() const {
+	return !replayer->IsRealtime();
+}
+
+bool taurus::ReplayCameraSource::IsFinished() const {
+	return finished.load();
+}
@@ -0,0 +1,316 @@
+#include "core/synthetic_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "core/frame_ring.h"
+#include "core/tracking/bayer.h"
+#include "core/tracking/synthetic.h"
+#include "core/tracking/tracking_utils.h"
+
+// generated rig, cameras on an arc around the stage, slightly above it and looking down at it (cm)
+static constexpr double STAGE_DISTANCE_CM = 200.0;
+static constexpr double RIG_ARC_DEGREES = 120.0;
+static constexpr double RIG_ELEVATION_DEGREES = 15.0;
+// roughly the PS3 Eye's focal length at 640x480, for cameras without an intrinsic calibration
+static constexpr double DEFAULT_FOCAL_LENGTH = 550.0;
+
+static constexpr int BACKGROUND_COUNT = 4;
+// the auto exposure lifts the background, good enough to make a lit room look different from dark mode
+static constexpr double AUTO_EXPOSURE_BACKGROUND = 60.0;
+
+glm::vec3 taurus::SyntheticBall::PositionAt(double seconds) const {
+	glm::vec3 position = offset;
+	for (int axis = 0; axis < 3; axis++) {
+		position[axis] += amplitude[axis] * static_cast<float>(std::sin(2.0 * CV_PI * frequency[axis] * seconds + phase[axis]));
+	}
+	return position;
+}
+
+cv::Scalar taurus::syntheticLedColor(int r, int g, int b) {
+	auto seen = [](int c) { return c * 0.82 + 20.0; };
+	return cv::Scalar(seen(b), seen(g), seen(r));
+}
+
+taurus::SyntheticScene::SyntheticScene(uint16_t fps) {
+	this->fps = fps;
+	Restart();
+}
+
+void taurus::SyntheticScene::AddBall(const SyntheticBall& ball) {
+	balls.push_back(ball);
+}
+
+void taurus::SyntheticScene::AddScriptedBall(const std::string& colorName, const cv::Scalar& color) {
+	// arm sized motion, every ball gets its own frequencies and phases so they cross each other now and then
+	float i = static_cast<float>(balls.size());
+
+	SyntheticBall ball;
+	ball.colorName = colorName;
+	ball.color = color;
+	ball.offset = glm::vec3(std::cos(i * 2.4f) * 20.f, std::sin(i * 1.7f) * 10.f, std::sin(i * 2.4f) * 20.f);
+	ball.amplitude = glm::vec3(40.f, 25.f, 30.f);
+	ball.frequency = glm::vec3(0.31f + 0.07f * i, 0.43f + 0.05f * i, 0.27f + 0.11f * i);
+	ball.phase = glm::vec3(i * 1.3f, i * 0.7f, i * 2.1f);
+	AddBall(ball);
+}
+
+size_t taurus::SyntheticScene::GetBallCount() const {
+	return balls.size();
+}
+
+const taurus::SyntheticBall& taurus::SyntheticScene::GetBall(size_t index) const {
+	return balls[index];
+}
+
+void taurus::SyntheticScene::SetStageCenter(const glm::vec3& center) {
+	stageCenter = center;
+}
+
+glm::vec3 taurus::SyntheticScene::GetStageCenter() const {
+	return stageCenter;
+}
+
+void taurus::SyntheticScene::Restart() {
+	startUs = captureClockUs();
+}
+
+uint16_t taurus::SyntheticScene::GetFps() const {
+	return fps;
+}
+
+int64_t taurus::SyntheticScene::GetFrameTimeUs(uint64_t frameIndex) const {
+	return startUs + static_cast<int64_t>(frameIndex) * 1000000 / fps;
+}
+
+uint64_t taurus::SyntheticScene::GetCurrentFrameIndex() const {
+	int64_t elapsed = std::max<int64_t>(captureClockUs() - startUs, 0);
+	return static_cast<uint64_t>(elapsed * fps / 1000000);
+}
+
+glm::vec3 taurus::SyntheticScene::GetBallPosition(size_t ballIndex, int64_t timestampUs) const {
+	double seconds = static_cast<double>(timestampUs - startUs) / 1000000.0;
+	return stageCenter + balls[ballIndex].PositionAt(seconds);
+}
+
+taurus::SyntheticView taurus::createSyntheticView(const CameraCalibration& calibration, const cv::Mat& originWorld, const cv::Size& frameSize) {
+	SyntheticView view;
+	view.projection = tracking::createCameraProjection(calibration.P, calibration.K, originWorld, frameSize);
+
+	if (!calibration.K.empty()) {
+		for (int r = 0; r < 3; r++) {
+			for (int c = 0; c < 3; c++) {
+				view.K(r, c) = calibration.K.at<double>(r, c);
+			}
+		}
+	}
+
+	// k1 k2 p1 p2 k3, anything past that is ignored
+	if (!calibration.distort.empty()) {
+		int count = std::min(static_cast<int>(calibration.distort.total()), 5);
+		for (int i = 0; i < count; i++) {
+			view.distort[i] = calibration.distort.at<double>(i);
+		}
+	}
+
+	return view;
+}
+
+bool taurus::projectSyntheticBall(const SyntheticView& view, const glm::vec3& worldPosition, cv::Point2f& center, float& radius) {
+	cv::Point2f undistorted;
+	float depth;
+	if (!tracking::projectWorldPoint(view.projection, worldPosition, undistorted, depth)) return false;
+
+	// same model as cv::projectPoints
+	double fx = view.K(0, 0);
+	double fy = view.K(1, 1);
+	double cx = view.K(0, 2);
+	double cy = view.K(1, 2);
+	double x = (undistorted.x - cx) / fx;
+	double y = (undistorted.y - cy) / fy;
+
+	const cv::Vec<double, 5>& d = view.distort;
+	double r2 = x * x + y * y;
+	double radial = 1.0 + d[0] * r2 + d[1] * r2 * r2 + d[4] * r2 * r2 * r2;
+	double xd = x * radial + 2.0 * d[2] * x * y + d[3] * (r2 + 2.0 * x * x);
+	double yd = y * radial + d[2] * (r2 + 2.0 * y * y) + 2.0 * d[3] * x * y;
+
+	center = cv::Point2f(static_cast<float>(xd * fx + cx), static_cast<float>(yd * fy + cy));
+	radius = static_cast<float>(fx) * tracking::BALL_RADIUS_CM / depth;
+	return true;
+}
+
+// private helper function
+// camera -> world transform of a camera at position, looking at target, with world y up (image y down)
+static cv::Mat lookAtCameraToWorld(const glm::dvec3& position, const glm::dvec3& target) {
+	glm::dvec3 forward = glm::normalize(target - position);
+	glm::dvec3 right = glm::normalize(glm::cross(forward, glm::dvec3(0.0, 1.0, 0.0)));
+	glm::dvec3 down = glm::cross(forward, right);
+
+	cv::Mat cameraToWorld = cv::Mat::eye(4, 4, CV_64F);
+	for (int r = 0; r < 3; r++) {
+		cameraToWorld.at<double>(r, 0) = right[r];
+		cameraToWorld.at<double>(r, 1) = down[r];
+		cameraToWorld.at<double>(r, 2) = forward[r];
+		cameraToWorld.at<double>(r, 3) = position[r];
+	}
+	return cameraToWorld;
+}
+
+void taurus::completeSyntheticCalibrations(std::vector<CameraCalibration>& calibrations, const cv::Size& frameSize) {
+	bool fullyCalibrated = !calibrations.empty();
+	for (CameraCalibration& calib : calibrations) {
+		fullyCalibrated = fullyCalibrated && calib.hasIntrinsic && calib.hasExtrinsic && !calib.P.empty();
+	}
+	if (fullyCalibrated) return;
+
+	int count = static_cast<int>(calibrations.size());
+	for (int i = 0; i < count; i++) {
+		CameraCalibration& calib = calibrations[i];
+
+		if (!calib.hasIntrinsic) {
+			double focalLength = DEFAULT_FOCAL_LENGTH * frameSize.width / 640.0;
+			calib.K = cv::Mat::eye(3, 3, CV_64F);
+			calib.K.at<double>(0, 0) = focalLength;
+			calib.K.at<double>(1, 1) = focalLength;
+			calib.K.at<double>(0, 2) = frameSize.width / 2.0;
+			calib.K.at<double>(1, 2) = frameSize.height / 2.0;
+			calib.distort = cv::Mat::zeros(1, 5, CV_64F);
+			calib.hasIntrinsic = true;
+		}
+
+		// spread over the arc, a single camera looks straight at the stage
+		double azimuth = count > 1 ? (-RIG_ARC_DEGREES / 2.0 + RIG_ARC_DEGREES * i / (count - 1)) : 0.0;
+		azimuth *= CV_PI / 180.0;
+		double elevation = RIG_ELEVATION_DEGREES * CV_PI / 180.0;
+		glm::dvec3 position = glm::dvec3(std::sin(azimuth) * std::cos(elevation), std::sin(elevation), -std::cos(azimuth) * std::cos(elevation)) * STAGE_DISTANCE_CM;
+
+		calib.world = lookAtCameraToWorld(position, glm::dvec3(0.0));
+		calib.hasExtrinsic = true;
+	}
+
+	// T is relative to camera 0, like the extrinsic calibrator does it
+	for (CameraCalibration& calib : calibrations) {
+		cv::Mat cameraFromOrigin = calib.world.inv() * calibrations[0].world;
+		calib.T = cameraFromOrigin(cv::Rect(0, 0, 4, 3)).clone();
+		calib.P = calib.K * calib.T;
+		calib.hasProjection = true;
+	}
+}
+
+glm::vec3 taurus::syntheticStageCenter(const std::vector<CameraCalibration>& calibrations) {
+	if (calibrations.empty() || calibrations[0].world.empty()) return glm::vec3(0.f);
+
+	// the generated rig's cameras are exactly this far from the world origin
+	cv::Point3f inFront = cv::Point3f(0.f, 0.f, static_cast<float>(STAGE_DISTANCE_CM));
+	return tracking::cvPoint3fToGlmVec3(tracking::transform(calibrations[0].world, inFront));
+}
+
+taurus::SyntheticCameraSource::SyntheticCameraSource(std::shared_ptr<SyntheticScene> scene, uint32_t seed) {
+	this->scene = scene;
+	rng = cv::RNG(seed);
+}
+
+const char* taurus::SyntheticCameraSource::GetName() const {
+	return "Synthetic";
+}
+
+void taurus::SyntheticCameraSource::Start(int width, int height, uint16_t fps) {
+	this->width = width;
+	this->height = height;
+
+	backgrounds.clear();
+	for (int i = 0; i < BACKGROUND_COUNT; i++) {
+		cv::Mat background = cv::Mat(height, width, CV_8UC3);
+		tracking::renderDarkBackground(background, rng);
+		backgrounds.push_back(background);
+	}
+
+	frameIndex = 0;
+}
+
+void taurus::SyntheticCameraSource::Stop() {
+	// nothing to release, the capture thread simply stops grabbing
+}
+
+int taurus::SyntheticCameraSource::GetWidth() const {
+	return width;
+}
+
+int taurus::SyntheticCameraSource::GetHeight() const {
+	return height;
+}
+
+void taurus::SyntheticCameraSource::SetExposureMode(ExposureMode mode) {
+	exposureMode.store(mode);
+}
+
+bool taurus::SyntheticCameraSource::SetFrameFormat(FrameFormat format) {
+	frameFormat = format;
+	return true;
+}
+
+taurus::FrameFormat taurus::SyntheticCameraSource::GetFrameFormat() const {
+	return frameFormat;
+}
+
+void taurus::SyntheticCameraSource::SetView(const SyntheticView& view) {
+	this->view = view;
+}
+
+void taurus::SyntheticCameraSource::GrabFrame(uint8_t* data, int64_t& timestampUs) {
+	// like a real sensor, a renderer that falls behind misses frames instead of delivering old ones
+	frameIndex = std::max(frameIndex, scene->GetCurrentFrameIndex());
+	timestampUs = scene->GetFrameTimeUs(frameIndex);
+	frameIndex++;
+
+	if (frameFormat == Frame_BAYER) {
+		// rendered in color, then sampled like the sensor's color filter would
+		thread_local cv::Mat rendered;
+		rendered.create(height, width, CV_8UC3);
+		Render(rendered, timestampUs);
+
+		cv::Mat frame = cv::Mat(height, width, CV_8UC1, data);
+		tracking::mosaicBgr(rendered, tracking::PS3EYE_BAYER_PATTERN, frame);
+	}
+	else {
+		cv::Mat frame = cv::Mat(height, width, CV_8UC3, data);
+		Render(frame, timestampUs);
+	}
+
+	// the frame is handed out at its capture time, not before
+	std::this_thread::sleep_for(std::chrono::microseconds(std::max<int64_t>(timestampUs - captureClockUs(), 0)));
+}
+
+void taurus::SyntheticCameraSource::Render(cv::Mat& frame, int64_t timestampUs) {
+	backgrounds[frameIndex % backgrounds.size()].copyTo(frame);
+	if (exposureMode.load() == Exposure_AUTO) {
+		cv::add(frame, cv::Scalar::all(AUTO_EXPOSURE_BACKGROUND), frame);
+	}
+
+	struct ProjectedBall {
+		cv::Point2f center;
+		float radius;
+		size_t index;
+	};
+	thread_local std::vector<ProjectedBall> projected;
+	projected.clear();
+
+	for (size_t i = 0; i < scene->GetBallCount(); i++) {
+		ProjectedBall ball;
+		ball.index = i;
+		if (projectSyntheticBall(view, scene->GetBallPosition(i, timestampUs), ball.center, ball.radius)) {
+			projected.push_back(ball);
+		}
+	}
+
+	// far balls first, so the near ones cover them
+	std::sort(projected.begin(), projected.end(), [](const ProjectedBall& a, const ProjectedBall& b) {
+		return a.radius < b.radius;
+	});
+	for (ProjectedBall& ball : projected) {
+		tracking::renderGlowingBall(frame, ball.center, ball.radius, scene->GetBall(ball.index).color);
+	}
+}
@@ -0,0 +1,88 @@
+#include "core/tracking/assignment.h"
+
+#include <algorithm>
+#include <limits>
+
+void taurus::tracking::solveGatedAssignment(const std::vector<float>& costs, int rows, int columns, float gate, std::vector<int>& rowToColumn) {
+	// potentials and augmenting paths, 1-based with index 0 as the virtual start
+	thread_local std::vector<double> square;
+	thread_local std::vector<double> u;
+	thread_local std::vector<double> v;
+	thread_local std::vector<double> minSlack;
+	thread_local std::vector<int> columnToRow;
+	thread_local std::vector<int> way;
+	thread_local std::vector<bool> used;
+
+	rowToColumn.assign(rows, -1);
+	if (rows <= 0 || columns <= 0) return;
+
+	// padded to a square, the padding is free
+	// a gated pair costs more than every feasible pair together, so it's only taken when nothing else can fill that row
+	int n = std::max(rows, columns);
+	double infeasible = (static_cast<double>(gate) + 1.0) * (n + 1);
+	square.assign(static_cast<size_t>(n) * n, 0.0);
+	for (int r = 0; r < rows; r++) {
+		for (int c = 0; c < columns; c++) {
+			float cost = costs[r * columns + c];
+			square[r * n + c] = cost <= gate ? cost : infeasible;
+		}
+	}
+
+	constexpr double INF = std::numeric_limits<double>::infinity();
+	u.assign(n + 1, 0.0);
+	v.assign(n + 1, 0.0);
+	columnToRow.assign(n + 1, 0);
+	way.assign(n + 1, 0);
+
+	for (int r = 1; r <= n; r++) {
+		columnToRow[0] = r;
+		int column = 0;
+		minSlack.assign(n + 1, INF);
+		used.assign(n + 1, false);
+
+		// grow the alternating tree until it reaches a free column
+		do {
+			used[column] = true;
+			int row = columnToRow[column];
+			double delta = INF;
+			int nextColumn = 0;
+
+			for (int c = 1; c <= n; c++) {
+				if (used[c]) continue;
+
+				double slack = square[(row - 1) * n + (c - 1)] - u[row] - v[c];
+				if (slack < minSlack[c]) {
+					minSlack[c] = slack;
+					way[c] = column;
+				}
+				if (minSlack[c] < delta) {
+					delta = minSlack[c];
+					nextColumn = c;
+				}
+			}
+
+			for (int c = 0; c <= n; c++) {
+				if (used[c]) {
+					u[columnToRow[c]] += delta;
+					v[c] -= delta;
+				}
+				else {
+					minSlack[c] -= delta;
+				}
+			}
+			column = nextColumn;
+		} while (columnToRow[column] != 0);
+
+		// flip the path
+		do {
+			int previous = way[column];
+			columnToRow[column] = columnToRow[previous];
+			column = previous;
+		} while (column != 0);
+	}
+
+	for (int c = 1; c <= columns; c++) {
+		int r = columnToRow[c] - 1;
+		if (r < rows && costs[r * columns + (c - 1)] <= gate) rowToColumn[r] = c - 1;
+	}
+}
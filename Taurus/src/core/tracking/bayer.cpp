@@ -0,0 +1,166 @@
+#include "core/tracking/bayer.h"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#include "core/tracking/tracking_utils.h"
+
+// extra mosaic pixels converted around a demosaiced window, cvtColor interpolates the edges of its input worse than the inside
+static constexpr int DEMOSAIC_MARGIN = 2;
+
+// private helper function
+// BGR channel index (0 = B, 1 = G, 2 = R) the sensor samples at this position of the 2x2 block
+static inline int bayerChannel(taurus::tracking::BayerPattern pattern, int y, int x) {
+	static constexpr int channels[4][4] = {
+		{ 0, 1, 1, 2 },  // BGGR
+		{ 1, 0, 2, 1 },  // GBRG
+		{ 1, 2, 0, 1 },  // GRBG
+		{ 2, 1, 1, 0 },  // RGGB
+	};
+	return channels[pattern][((y & 1) << 1) | (x & 1)];
+}
+
+int taurus::tracking::bayerToBgrCode(BayerPattern pattern) {
+	// opencv names its bayer codes by the second row's second and third pixel, not by the top left block
+	switch (pattern) {
+		case Bayer_BGGR:
+			return cv::COLOR_BayerRG2BGR;
+		case Bayer_GBRG:
+			return cv::COLOR_BayerGR2BGR;
+		case Bayer_GRBG:
+			return cv::COLOR_BayerGB2BGR;
+		case Bayer_RGGB:
+		default:
+			return cv::COLOR_BayerBG2BGR;
+	}
+}
+
+cv::Rect taurus::tracking::findBrightBayerBounds(const cv::Mat& bayer, const cv::Rect& roi, int threshold, const cv::Mat* ignore) {
+	CV_Assert(bayer.type() == CV_8UC1);
+	thread_local std::vector<uchar> masked;
+
+	cv::Rect area = roi & createFrameRoi(bayer);
+	int minX = INT_MAX;
+	int maxX = -1;
+	int minY = INT_MAX;
+	int maxY = -1;
+
+	for (int y = area.y; y < area.y + area.height; y++) {
+		const uchar* row = bayer.ptr<uchar>(y) + area.x;
+		if (ignore != nullptr) {
+			// the ignored samples are cleared in a copy of the row, the mask is 255 where they are
+			const uchar* ignoreRow = ignore->ptr<uchar>(y) + area.x;
+			masked.resize(area.width);
+			for (int x = 0; x < area.width; x++) {
+				masked[x] = row[x] & static_cast<uchar>(~ignoreRow[x]);
+			}
+			row = masked.data();
+		}
+
+		// most rows are completely dark, a plain max over the row vectorizes well and rejects them quickly
+		uchar brightest = 0;
+		for (int x = 0; x < area.width; x++) {
+			brightest = std::max(brightest, row[x]);
+		}
+		if (brightest < threshold) continue;
+
+		int first = 0;
+		while (row[first] < threshold) first++;
+		int last = area.width - 1;
+		while (row[last] < threshold) last--;
+
+		minX = std::min(minX, area.x + first);
+		maxX = std::max(maxX, area.x + last);
+		minY = std::min(minY, y);
+		maxY = y;
+	}
+
+	if (maxY < 0) return cv::Rect();
+	return cv::Rect(minX, minY, maxX - minX + 1, maxY - minY + 1);
+}
+
+void taurus::tracking::demosaicWindow(const cv::Mat& bayer, const cv::Rect& window, BayerPattern pattern, cv::Mat& bgr) {
+	CV_Assert(bayer.type() == CV_8UC1);
+	thread_local cv::Mat converted;
+
+	// pixels outside the demosaiced windows are never meant to be read, a black frame keeps them harmless if they are
+	if (bgr.size() != bayer.size() || bgr.type() != CV_8UC3) {
+		bgr.create(bayer.size(), CV_8UC3);
+		bgr.setTo(cv::Scalar::all(0));
+	}
+
+	cv::Rect frameRoi = createFrameRoi(bayer);
+	cv::Rect target = window & frameRoi;
+	if (target.empty()) return;
+
+	// the converted area starts on an even pixel, so it has the same pattern as the whole frame
+	int x1 = std::max(target.x - DEMOSAIC_MARGIN, 0) & ~1;
+	int y1 = std::max(target.y - DEMOSAIC_MARGIN, 0) & ~1;
+	int x2 = std::min(target.x + target.width + DEMOSAIC_MARGIN, bayer.cols);
+	int y2 = std::min(target.y + target.height + DEMOSAIC_MARGIN, bayer.rows);
+	cv::Rect source(x1, y1, x2 - x1, y2 - y1);
+
+	cv::cvtColor(bayer(source), converted, bayerToBgrCode(pattern));
+	cv::Mat targetPixels = bgr(target);
+	converted(target - source.tl()).copyTo(targetPixels);
+}
+
+void taurus::tracking::demosaicFrame(const cv::Mat& bayer, BayerPattern pattern, cv::Mat& bgr) {
+	cv::cvtColor(bayer, bgr, bayerToBgrCode(pattern));
+}
+
+void taurus::tracking::binBayer(const cv::Mat& bayer, BayerPattern pattern, cv::Mat& bgr) {
+	CV_Assert(bayer.type() == CV_8UC1);
+
+	int width = bayer.cols / 2;
+	int height = bayer.rows / 2;
+	bgr.create(height, width, CV_8UC3);
+
+	// where every channel sits in the 2x2 block, the two greens are averaged
+	int blueX = 0, blueY = 0, redX = 0, redY = 0;
+	int greenX[2] = {}, greenY[2] = {};
+	int greens = 0;
+	for (int i = 0; i < 4; i++) {
+		int y = i >> 1;
+		int x = i & 1;
+		switch (bayerChannel(pattern, y, x)) {
+			case 0: blueX = x; blueY = y; break;
+			case 2: redX = x; redY = y; break;
+			default: greenX[greens] = x; greenY[greens] = y; greens++; break;
+		}
+	}
+
+	for (int y = 0; y < height; y++) {
+		const uchar* rows[2] = { bayer.ptr<uchar>(y * 2), bayer.ptr<uchar>(y * 2 + 1) };
+		uchar* out = bgr.ptr<uchar>(y);
+
+		for (int x = 0; x < width; x++) {
+			int cx = x * 2;
+			out[x * 3 + 0] = rows[blueY][cx + blueX];
+			out[x * 3 + 1] = static_cast<uchar>((rows[greenY[0]][cx + greenX[0]] + rows[greenY[1]][cx + greenX[1]] + 1) >> 1);
+			out[x * 3 + 2] = rows[redY][cx + redX];
+		}
+	}
+}
+
+void taurus::tracking::mosaicBgr(const cv::Mat& bgr, BayerPattern pattern, cv::Mat& bayer) {
+	CV_Assert(bgr.type() == CV_8UC3);
+
+	bayer.create(bgr.size(), CV_8UC1);
+	for (int y = 0; y < bgr.rows; y++) {
+		const uchar* in = bgr.ptr<uchar>(y);
+		uchar* out = bayer.ptr<uchar>(y);
+
+		int even = bayerChannel(pattern, y, 0);
+		int odd = bayerChannel(pattern, y, 1);
+		for (int x = 0; x + 1 < bgr.cols; x += 2) {
+			out[x] = in[x * 3 + even];
+			out[x + 1] = in[x * 3 + 3 + odd];
+		}
+		if (bgr.cols & 1) {
+			int x = bgr.cols - 1;
+			out[x] = in[x * 3 + even];
+		}
+	}
+}
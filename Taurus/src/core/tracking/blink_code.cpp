@@ -0,0 +1,133 @@
+#include "core/tracking/blink_code.h"
+
+#include <algorithm>
+#include <cmath>
+
+// one code of every necklace class used, none of them periodic, the most balanced ones first
+static constexpr uint8_t blinkCodes[] = { 0b000111, 0b001011, 0b001101, 0b010111, 0b000101, 0b001111, 0b000011, 0b011111, 0b000001 };
+
+// the LED steps are searched in this many phases, the camera and controller clocks aren't related
+static constexpr int BLINK_PHASES = 10;
+
+// private helper function
+static bool codeBit(uint8_t code, int64_t step) {
+	int bit = static_cast<int>(step % taurus::tracking::BLINK_CODE_BITS);
+	return (code >> (taurus::tracking::BLINK_CODE_BITS - 1 - bit)) & 1;
+}
+
+int taurus::tracking::blinkCodeCount() {
+	return static_cast<int>(std::size(blinkCodes));
+}
+
+uint8_t taurus::tracking::blinkCode(int index) {
+	return blinkCodes[index % blinkCodeCount()];
+}
+
+float taurus::tracking::blinkLevel(uint8_t code, int64_t ticksMs) {
+	return codeBit(code, ticksMs / BLINK_STEP_MS) ? 1.f : BLINK_DIM_LEVEL;
+}
+
+float taurus::tracking::ballIntensity(const cv::Mat& frame, const cv::Rect& bounds) {
+	cv::Rect area = bounds & cv::Rect(0, 0, frame.cols, frame.rows);
+	if (area.empty()) return 0.f;
+
+	cv::Scalar mean = cv::mean(frame(area));
+	int channels = std::min(frame.channels(), 3);
+	double sum = 0.0;
+	for (int c = 0; c < channels; c++) {
+		sum += mean[c];
+	}
+	return static_cast<float>(sum / channels);
+}
+
+void taurus::tracking::BlinkDecoder::Reset() {
+	samples.clear();
+}
+
+void taurus::tracking::BlinkDecoder::AddSample(int64_t timestampUs, float intensity) {
+	samples.push_back({ timestampUs, intensity });
+}
+
+int64_t taurus::tracking::BlinkDecoder::GetDurationUs() const {
+	if (samples.empty()) return 0;
+	return samples.back().timestampUs - samples.front().timestampUs;
+}
+
+float taurus::tracking::BlinkDecoder::Match(uint8_t code) const {
+	thread_local std::vector<double> stepSums;
+	thread_local std::vector<int> stepCounts;
+
+	const int64_t stepUs = static_cast<int64_t>(BLINK_STEP_MS) * 1000;
+	if (GetDurationUs() < stepUs * (BLINK_CODE_BITS + 1)) return 0.f;
+
+	double sampleSum = 0.0;
+	for (const Sample& sample : samples) {
+		sampleSum += sample.intensity;
+	}
+	double sampleMean = sampleSum / samples.size();
+
+	// the LED steps in the phase where they're sharpest, a step straddling two bits looks like the bits of another code
+	int64_t origin = 0;
+	int steps = 0;
+	double bestContrast = -1.0;
+	for (int phase = 0; phase < BLINK_PHASES; phase++) {
+		int64_t phaseOrigin = samples.front().timestampUs - stepUs * phase / BLINK_PHASES;
+		int phaseSteps = static_cast<int>((samples.back().timestampUs - phaseOrigin) / stepUs) + 1;
+		stepSums.assign(phaseSteps, 0.0);
+		stepCounts.assign(phaseSteps, 0);
+		for (const Sample& sample : samples) {
+			int step = static_cast<int>((sample.timestampUs - phaseOrigin) / stepUs);
+			stepSums[step] += sample.intensity;
+			stepCounts[step]++;
+		}
+
+		double contrast = 0.0;
+		for (int s = 0; s < phaseSteps; s++) {
+			if (stepCounts[s] == 0) continue;
+
+			double deviation = stepSums[s] / stepCounts[s] - sampleMean;
+			contrast += stepCounts[s] * deviation * deviation;
+		}
+		if (contrast > bestContrast) {
+			bestContrast = contrast;
+			origin = phaseOrigin;
+			steps = phaseSteps;
+		}
+	}
+
+	// the mean brightness of every step of that phase, steps without a sample are skipped
+	stepSums.assign(steps, 0.0);
+	stepCounts.assign(steps, 0);
+	for (const Sample& sample : samples) {
+		int step = static_cast<int>((sample.timestampUs - origin) / stepUs);
+		stepSums[step] += sample.intensity;
+		stepCounts[step]++;
+	}
+
+	// the correlation doesn't care about the exposure, only about the brightness following the code
+	float best = 0.f;
+	for (int rotation = 0; rotation < BLINK_CODE_BITS; rotation++) {
+		double n = 0.0;
+		double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumYY = 0.0, sumXY = 0.0;
+		for (int s = 0; s < steps; s++) {
+			if (stepCounts[s] == 0) continue;
+
+			double x = stepSums[s] / stepCounts[s];
+			double y = codeBit(code, s + rotation) ? 1.0 : BLINK_DIM_LEVEL;
+			n += 1.0;
+			sumX += x;
+			sumY += y;
+			sumXX += x * x;
+			sumYY += y * y;
+			sumXY += x * y;
+		}
+
+		double covariance = sumXY - sumX * sumY / n;
+		double variance = (sumXX - sumX * sumX / n) * (sumYY - sumY * sumY / n);
+		if (!(variance > 0.0)) continue;
+
+		best = std::max(best, static_cast<float>(covariance / std::sqrt(variance)));
+	}
+
+	return best;
+}
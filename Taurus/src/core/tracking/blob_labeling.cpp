@@ -0,0 +1,178 @@
+#include "core/tracking/blob_labeling.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+// a horizontal run of bright pixels, x1 is inclusive
+struct PixelRun {
+	int y;
+	int x0;
+	int x1;
+	int parent;
+};
+
+// running sums of a blob, turned into BlobStats at the end
+struct BlobAccumulator {
+	int64_t area = 0;
+	int64_t sumX = 0;
+	int64_t sumY = 0;
+	int64_t sumXX = 0;
+	int64_t sumXY = 0;
+	int64_t sumYY = 0;
+	int minX = INT32_MAX;
+	int minY = INT32_MAX;
+	int maxX = -1;
+	int maxY = -1;
+	std::array<int, taurus::tracking::MAX_SEGMENT_COLORS> colorVotes = {};
+};
+
+// private helper function
+static int findRoot(std::vector<PixelRun>& runs, int i) {
+	while (runs[i].parent != i) {
+		// path halving
+		runs[i].parent = runs[runs[i].parent].parent;
+		i = runs[i].parent;
+	}
+	return i;
+}
+
+// private helper function
+static void unite(std::vector<PixelRun>& runs, int a, int b) {
+	a = findRoot(runs, a);
+	b = findRoot(runs, b);
+	if (a == b) return;
+
+	// the older run stays the root, so roots always come before their children
+	if (a < b) runs[b].parent = a;
+	else runs[a].parent = b;
+}
+
+float taurus::tracking::BlobStats::equivalentRadius() const {
+	return std::sqrt(static_cast<float>(area) / std::numbers::pi_v<float>);
+}
+
+float taurus::tracking::BlobStats::elongation() const {
+	// eigenvalues of the covariance matrix
+	float common = std::sqrt((mu20 - mu02) * (mu20 - mu02) + 4.f * mu11 * mu11);
+	float major = (mu20 + mu02 + common) / 2.f;
+	float minor = (mu20 + mu02 - common) / 2.f;
+
+	if (minor <= 0.f) return major > 0.f ? INFINITY : 1.f;
+	return std::sqrt(major / minor);
+}
+
+int taurus::tracking::BlobStats::dominantColor() const {
+	int best = -1;
+	int bestVotes = 0;
+	for (int k = 0; k < static_cast<int>(colorVotes.size()); k++) {
+		if (colorVotes[k] > bestVotes) {
+			bestVotes = colorVotes[k];
+			best = k;
+		}
+	}
+
+	return best;
+}
+
+void taurus::tracking::labelBlobs(const cv::Mat& classes, std::vector<BlobStats>& blobs, int minArea) {
+	CV_Assert(classes.type() == CV_8UC1);
+	blobs.clear();
+
+	thread_local std::vector<PixelRun> runs;
+	thread_local std::vector<int> rootToBlob;
+	thread_local std::vector<BlobAccumulator> accumulators;
+	runs.clear();
+
+	// run-length encode the rows, and connect every run to the runs of the previous row that it touches (8-connectivity)
+	int previousRowStart = 0;
+	int previousRowEnd = 0;
+	for (int y = 0; y < classes.rows; y++) {
+		const uchar* row = classes.ptr<uchar>(y);
+		int rowStart = static_cast<int>(runs.size());
+
+		int x = 0;
+		while (x < classes.cols) {
+			if (!(row[x] & CLASS_BRIGHT_BIT)) {
+				x++;
+				continue;
+			}
+
+			int x0 = x;
+			while (x < classes.cols && (row[x] & CLASS_BRIGHT_BIT)) x++;
+
+			int index = static_cast<int>(runs.size());
+			runs.push_back({ y, x0, x - 1, index });
+		}
+		int rowEnd = static_cast<int>(runs.size());
+
+		// both rows are sorted by x, so a single sweep finds every overlap
+		int p = previousRowStart;
+		for (int r = rowStart; r < rowEnd; r++) {
+			while (p < previousRowEnd && runs[p].x1 + 1 < runs[r].x0) p++;
+
+			for (int q = p; q < previousRowEnd && runs[q].x0 <= runs[r].x1 + 1; q++) {
+				unite(runs, q, r);
+			}
+		}
+
+		previousRowStart = rowStart;
+		previousRowEnd = rowEnd;
+	}
+
+	// accumulate the statistics of every blob
+	rootToBlob.assign(runs.size(), -1);
+	accumulators.clear();
+	for (int i = 0; i < static_cast<int>(runs.size()); i++) {
+		int root = findRoot(runs, i);
+		if (rootToBlob[root] < 0) {
+			rootToBlob[root] = static_cast<int>(accumulators.size());
+			accumulators.emplace_back();
+		}
+
+		const PixelRun& run = runs[i];
+		BlobAccumulator& acc = accumulators[rootToBlob[root]];
+
+		// closed form sums over x0..x1
+		int64_t length = run.x1 - run.x0 + 1;
+		int64_t sumX = (static_cast<int64_t>(run.x0) + run.x1) * length / 2;
+		int64_t sumXX = (static_cast<int64_t>(run.x1) * (run.x1 + 1) * (2 * run.x1 + 1) - static_cast<int64_t>(run.x0 - 1) * run.x0 * (2 * run.x0 - 1)) / 6;
+
+		acc.area += length;
+		acc.sumX += sumX;
+		acc.sumY += length * run.y;
+		acc.sumXX += sumXX;
+		acc.sumXY += sumX * run.y;
+		acc.sumYY += length * run.y * run.y;
+		acc.minX = std::min(acc.minX, run.x0);
+		acc.maxX = std::max(acc.maxX, run.x1);
+		acc.minY = std::min(acc.minY, run.y);
+		acc.maxY = std::max(acc.maxY, run.y);
+
+		// color votes, the runs are short so reading the pixels again is cheap
+		const uchar* row = classes.ptr<uchar>(run.y);
+		for (int x = run.x0; x <= run.x1; x++) {
+			for (unsigned int bits = row[x] & CLASS_COLOR_BITS; bits != 0; bits &= bits - 1) {
+				acc.colorVotes[std::countr_zero(bits)]++;
+			}
+		}
+	}
+
+	for (const BlobAccumulator& acc : accumulators) {
+		if (acc.area < minArea) continue;
+
+		BlobStats& blob = blobs.emplace_back();
+		double area = static_cast<double>(acc.area);
+		double cx = acc.sumX / area;
+		double cy = acc.sumY / area;
+
+		blob.area = static_cast<int>(acc.area);
+		blob.bounds = cv::Rect(acc.minX, acc.minY, acc.maxX - acc.minX + 1, acc.maxY - acc.minY + 1);
+		blob.centroid = cv::Point2f(static_cast<float>(cx), static_cast<float>(cy));
+		blob.mu20 = static_cast<float>(acc.sumXX / area - cx * cx);
+		blob.mu11 = static_cast<float>(acc.sumXY / area - cx * cy);
+		blob.mu02 = static_cast<float>(acc.sumYY / area - cy * cy);
+		blob.colorVotes = acc.colorVotes;
+	}
+}
@@ -0,0 +1,64 @@
+#include "core/tracking/brightness.h"
+
+#include <algorithm>
+#include <cmath>
+
+// how much of the running histogram the newest frame makes up
+static constexpr float HISTOGRAM_ALPHA = 0.2f;
+// about this many pixels of a roi are sampled, so every roi costs the same
+static constexpr int MAX_HISTOGRAM_SAMPLES = 4096;
+// pixels the gate lets through, as a multiple of the ball's area (the glow and the motion blur around it need some room)
+static constexpr float CANDIDATE_AREA_FACTOR = 3.f;
+// the gate only moves once the histogram asks for more than this many gray levels, so it doesn't flicker between frames
+static constexpr int THRESHOLD_HYSTERESIS = 6;
+
+static constexpr int HISTOGRAM_SHIFT = 2;  // 256 gray levels into 64 bins
+
+void taurus::tracking::updateAdaptiveThreshold(const cv::Mat& frame, const cv::Rect& roi, float ballRadius, AdaptiveThreshold& state) {
+	cv::Rect area = roi & cv::Rect(0, 0, frame.cols, frame.rows);
+	if (area.empty() || ballRadius <= 0.f) return;
+
+	// odd steps, so a bayer mosaic is sampled in all of its colors
+	int step = static_cast<int>(std::sqrt(static_cast<float>(area.area()) / MAX_HISTOGRAM_SAMPLES));
+	step = std::max(step, 1) | 1;
+
+	std::array<int, BRIGHTNESS_HISTOGRAM_BINS> counts = {};
+	int samples = 0;
+	bool isBayer = frame.type() == CV_8UC1;
+	for (int y = area.y; y < area.y + area.height; y += step) {
+		const uchar* row = frame.ptr<uchar>(y);
+		for (int x = area.x; x < area.x + area.width; x += step) {
+			int value;
+			if (isBayer) {
+				value = row[x];
+			}
+			else {
+				// BGR2GRAY weights in 8 bit fixed point
+				const uchar* px = row + x * 3;
+				value = (px[0] * 29 + px[1] * 150 + px[2] * 77) >> 8;
+			}
+
+			counts[value >> HISTOGRAM_SHIFT]++;
+			samples++;
+		}
+	}
+
+	float alpha = state.hasHistogram ? HISTOGRAM_ALPHA : 1.f;
+	for (int b = 0; b < BRIGHTNESS_HISTOGRAM_BINS; b++) {
+		float fraction = static_cast<float>(counts[b]) / static_cast<float>(samples);
+		state.histogram[b] += (fraction - state.histogram[b]) * alpha;
+	}
+	state.hasHistogram = true;
+
+	// the brightest bins that together make up the candidate area, the gate is the lower edge of the last one
+	float targetFraction = std::min(CANDIDATE_AREA_FACTOR * static_cast<float>(CV_PI) * ballRadius * ballRadius / static_cast<float>(area.area()), 1.f);
+	float passing = 0.f;
+	int bin = BRIGHTNESS_HISTOGRAM_BINS - 1;
+	for (; bin > 0; bin--) {
+		passing += state.histogram[bin];
+		if (passing >= targetFraction) break;
+	}
+
+	int wanted = std::clamp(bin << HISTOGRAM_SHIFT, MIN_BRIGHT_THRESHOLD, MAX_BRIGHT_THRESHOLD);
+	if (std::abs(wanted - state.threshold) > THRESHOLD_HYSTERESIS) state.threshold = wanted;
+}
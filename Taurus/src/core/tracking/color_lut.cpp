@@ -0,0 +1,74 @@
+#include "core/tracking/color_lut.h"
+
+void taurus::tracking::ColorLut::Build(const std::vector<HsvColorRange>& colors, int brightThreshold) {
+	CV_Assert(colors.size() <= MAX_SEGMENT_COLORS);
+
+	// the center of every bin, as a single row image so opencv does the conversions the same way as everywhere else
+	constexpr int SHIFT = 8 - COLOR_LUT_BITS;
+	constexpr int HALF_BIN = (1 << SHIFT) / 2;
+
+	cv::Mat binCenters = cv::Mat(1, COLOR_LUT_SIZE, CV_8UC3);
+	uchar* centers = binCenters.ptr<uchar>(0);
+	for (int b = 0; b < COLOR_LUT_BINS; b++) {
+		for (int g = 0; g < COLOR_LUT_BINS; g++) {
+			for (int r = 0; r < COLOR_LUT_BINS; r++) {
+				int i = (b << (2 * COLOR_LUT_BITS)) | (g << COLOR_LUT_BITS) | r;
+				centers[i * 3 + 0] = static_cast<uchar>((b << SHIFT) + HALF_BIN);
+				centers[i * 3 + 1] = static_cast<uchar>((g << SHIFT) + HALF_BIN);
+				centers[i * 3 + 2] = static_cast<uchar>((r << SHIFT) + HALF_BIN);
+			}
+		}
+	}
+
+	cv::Mat gray, hsv;
+	cv::cvtColor(binCenters, gray, cv::COLOR_BGR2GRAY);
+	cv::cvtColor(binCenters, hsv, cv::COLOR_BGR2HSV);
+
+	table = std::vector<uchar>(COLOR_LUT_SIZE, 0);
+	const uchar* grayValues = gray.ptr<uchar>(0);
+	const uchar* hsvValues = hsv.ptr<uchar>(0);
+	for (int i = 0; i < COLOR_LUT_SIZE; i++) {
+		// dark bins are background, whatever their color, bright is above the threshold like in the fused kernel
+		if (grayValues[i] <= brightThreshold) continue;
+
+		uchar bits = CLASS_BRIGHT_BIT;
+		for (size_t k = 0; k < colors.size(); k++) {
+			bool inRange = true;
+			for (int c = 0; c < 3; c++) {
+				uchar value = hsvValues[i * 3 + c];
+				inRange = inRange && value >= colors[k].lower[c] && value <= colors[k].upper[c];
+			}
+
+			if (inRange) bits |= static_cast<uchar>(1 << k);
+		}
+		table[i] = bits;
+	}
+
+	colorCount = colors.size();
+	this->brightThreshold = brightThreshold;
+}
+
+void taurus::tracking::ColorLut::Clear() {
+	table.clear();
+	colorCount = 0;
+}
+
+bool taurus::tracking::ColorLut::IsBuilt() const {
+	return table.size() == COLOR_LUT_SIZE;
+}
+
+size_t taurus::tracking::ColorLut::GetColorCount() const {
+	return colorCount;
+}
+
+int taurus::tracking::ColorLut::GetBrightThreshold() const {
+	return brightThreshold;
+}
+
+const uchar* taurus::tracking::ColorLut::Data() const {
+	return table.data();
+}
+
+uchar taurus::tracking::ColorLut::Lookup(uchar b, uchar g, uchar r) const {
+	return table[Index(b, g, r)];
+}
@@ -0,0 +1,209 @@
+#include "core/tracking/correspondence.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/tracking/assignment.h"
+
+// pixels added to a ball's cost for every camera that doesn't see it, a stray same colored light is usually only seen by one
+static constexpr float MISSING_VIEW_COST = 4.f;
+
+void taurus::tracking::EpipolarGeometry::Build(const std::vector<TriangulationCamera>& cameras) {
+	cameraCount = static_cast<int>(cameras.size());
+	fundamentals.assign(static_cast<size_t>(cameraCount) * cameraCount, cv::Matx33d::zeros());
+	valid.assign(static_cast<size_t>(cameraCount) * cameraCount, false);
+	pixelScales.clear();
+
+	for (int b = 0; b < cameraCount; b++) {
+		pixelScales.push_back(cameras[b].pixelScale);
+
+		for (int a = 0; a < cameraCount; a++) {
+			if (a == b || !cameras[a].valid || !cameras[b].valid) continue;
+
+			cv::Mat F;
+			fundamentalFromProjections(cv::Mat(cameras[a].P), cv::Mat(cameras[b].P), F);
+			for (int r = 0; r < 3; r++) {
+				for (int c = 0; c < 3; c++) {
+					fundamentals[b * cameraCount + a](r, c) = F.at<double>(r, c);
+				}
+			}
+			valid[b * cameraCount + a] = true;
+		}
+	}
+}
+
+bool taurus::tracking::EpipolarGeometry::HasPair(int cameraA, int cameraB) const {
+	if (cameraA < 0 || cameraB < 0 || cameraA >= cameraCount || cameraB >= cameraCount) return false;
+	return valid[cameraB * cameraCount + cameraA];
+}
+
+float taurus::tracking::EpipolarGeometry::Distance(const ViewObservation& a, const ViewObservation& b) const {
+	const cv::Matx33d& F = fundamentals[b.camera * cameraCount + a.camera];
+	cv::Vec3d xa = cv::Vec3d(a.point.x, a.point.y, 1.0);
+	cv::Vec3d xb = cv::Vec3d(b.point.x, b.point.y, 1.0);
+
+	cv::Vec3d lineB = F * xa;
+	cv::Vec3d lineA = F.t() * xb;
+	double error = std::abs(xb.dot(lineB));
+
+	double distanceB = error / std::max(std::hypot(lineB[0], lineB[1]), 1e-12) * pixelScales[b.camera];
+	double distanceA = error / std::max(std::hypot(lineA[0], lineA[1]), 1e-12) * pixelScales[a.camera];
+	return static_cast<float>((distanceA + distanceB) * 0.5);
+}
+
+namespace
+{
+	// one camera's detection of a ball of the group
+	struct GroupDetection {
+		taurus::tracking::TrackedObject::PerCameraData data;
+		taurus::tracking::ViewObservation view;
+		bool used = false;
+	};
+}
+
+void taurus::tracking::matchSameColorObjects(const std::vector<TriangulationCamera>& cameras, const std::vector<const UndistortionGrid*>& grids, const EpipolarGeometry& epipolar, const std::vector<TrackedObject*>& group) {
+	thread_local std::vector<GroupDetection> detections;
+	thread_local std::vector<int> cameraOrder;
+	thread_local std::vector<int> cameraDetections;
+	thread_local std::vector<int> hypotheses;  // per ball, the detection every camera contributes (or -1), camera count entries each
+	thread_local std::vector<int> references;
+	thread_local std::vector<int> candidates;
+	thread_local std::vector<float> costs;
+	thread_local std::vector<int> assignment;
+
+	int cameraCount = static_cast<int>(cameras.size());
+	int objectCount = static_cast<int>(group.size());
+	if (cameraCount == 0 || objectCount == 0) return;
+
+	// every distinct detection of the group, objects that locked onto the same blob only count once
+	detections.clear();
+	cameraDetections.assign(cameraCount, 0);
+	for (int c = 0; c < cameraCount; c++) {
+		for (TrackedObject* obj : group) {
+			const TrackedObject::PerCameraData& data = obj->perCameraData[c];
+			if (!data.acquiredTracking) continue;
+
+			bool duplicate = false;
+			for (const GroupDetection& detection : detections) {
+				float sameBlob = std::max(detection.data.circleRadius, 1.f);
+				if (detection.view.camera == c && cv::norm(detection.data.globalCircleCenter - data.globalCircleCenter) < sameBlob) duplicate = true;
+			}
+			if (duplicate) continue;
+
+			GroupDetection& detection = detections.emplace_back();
+			detection.data = data;
+			// as captured, the image motion belongs to the objects and is only updated once they have their detections
+			detection.view = createViewObservation(c, data, *grids[c], data.timestampUs);
+			cameraDetections[c]++;
+		}
+	}
+
+	// the cameras seeing the most balls anchor the matching, the others are matched to them
+	cameraOrder.clear();
+	for (int c = 0; c < cameraCount; c++) {
+		cameraOrder.push_back(c);
+	}
+	std::stable_sort(cameraOrder.begin(), cameraOrder.end(), [&](int a, int b) { return cameraDetections[a] > cameraDetections[b]; });
+
+	hypotheses.clear();
+	for (int reference : cameraOrder) {
+		references.clear();
+		for (int d = 0; d < detections.size(); d++) {
+			if (detections[d].view.camera == reference && !detections[d].used) references.push_back(d);
+		}
+		if (references.empty()) continue;
+
+		size_t firstBall = hypotheses.size() / cameraCount;
+		for (int d : references) {
+			detections[d].used = true;
+			hypotheses.insert(hypotheses.end(), cameraCount, -1);
+			hypotheses[hypotheses.size() - cameraCount + reference] = d;
+		}
+
+		// every other camera's leftover detections, by their distance to the reference detections' epipolar lines
+		for (int c : cameraOrder) {
+			if (c == reference || !epipolar.HasPair(reference, c)) continue;
+
+			candidates.clear();
+			for (int d = 0; d < detections.size(); d++) {
+				if (detections[d].view.camera == c && !detections[d].used) candidates.push_back(d);
+			}
+			if (candidates.empty()) continue;
+
+			costs.clear();
+			for (int r : references) {
+				for (int d : candidates) {
+					costs.push_back(epipolar.Distance(detections[r].view, detections[d].view));
+				}
+			}
+
+			solveGatedAssignment(costs, static_cast<int>(references.size()), static_cast<int>(candidates.size()), EPIPOLAR_GATE, assignment);
+			for (size_t r = 0; r < references.size(); r++) {
+				if (assignment[r] < 0) continue;
+
+				int d = candidates[assignment[r]];
+				detections[d].used = true;
+				hypotheses[(firstBall + r) * cameraCount + c] = d;
+			}
+		}
+	}
+
+	// the balls go to the objects predicted closest to them, objects without a prediction take what's left
+	int ballCount = static_cast<int>(hypotheses.size() / cameraCount);
+	float gate = PREDICTION_GATE + MISSING_VIEW_COST * cameraCount;
+	costs.clear();
+	for (TrackedObject* obj : group) {
+		for (int b = 0; b < ballCount; b++) {
+			float distance = 0.f;
+			int predicted = 0;
+			int missing = 0;
+
+			for (int c = 0; c < cameraCount; c++) {
+				int d = hypotheses[b * cameraCount + c];
+				if (d < 0) {
+					missing++;
+					continue;
+				}
+
+				const TrackedObject::PerCameraData& data = obj->perCameraData[c];
+				if (data.hasPrediction) {
+					distance += static_cast<float>(cv::norm(detections[d].data.globalCircleCenter - data.predictedCenter));
+					predicted++;
+				}
+			}
+
+			distance = predicted > 0 ? distance / predicted : PREDICTION_GATE;
+			costs.push_back(distance <= PREDICTION_GATE ? distance + MISSING_VIEW_COST * missing : gate + 1.f);
+		}
+	}
+	solveGatedAssignment(costs, objectCount, ballCount, gate, assignment);
+
+	// the objects keep their own color, prediction, image motion and brightness gate, everything else comes from the detection they got
+	for (int o = 0; o < objectCount; o++) {
+		for (int c = 0; c < cameraCount; c++) {
+			TrackedObject::PerCameraData& data = group[o]->perCameraData[c];
+			int d = assignment[o] < 0 ? -1 : hypotheses[assignment[o] * cameraCount + c];
+			if (d < 0) {
+				data.acquiredTracking = false;
+				continue;
+			}
+
+			HsvColorRange color = data.color;
+			bool hasPrediction = data.hasPrediction;
+			cv::Point2f predictedCenter = data.predictedCenter;
+			TrackedObject::ImageMotion motion = data.motion;
+			AdaptiveThreshold brightness = data.brightness;
+
+			data = detections[d].data;
+			data.color = color;
+			data.hasPrediction = hasPrediction;
+			data.predictedCenter = predictedCenter;
+			data.motion = motion;
+			data.brightness = brightness;
+
+			// the rest patch buffer could now be shared with another object, the next capture gets its own
+			data.restPatch.release();
+			data.restRect = cv::Rect();
+		}
+	}
+}
@@ -1,18 +1,28 @@
 #include "core/tracking/detector.h"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
+#include "core/tracking/assignment.h"
+#include "core/tracking/bayer.h"
+#include "core/tracking/blob_labeling.h"
+#include "core/tracking/color_lut.h"
+#include "core/tracking/mean_shift.h"
+#include "core/tracking/motion_gate.h"
+#include "core/tracking/region_planner.h"
+#include "core/tracking/segmentation.h"
 #include "core/utils.h"
 #include "core/logging.h"
 
-void taurus::tracking::maskBrightBlobs(const cv::Mat& frame, cv::Mat& masked, cv::Mat& mask) {
+void taurus::tracking::maskBrightBlobs(const cv::Mat& frame, cv::Mat& masked, cv::Mat& mask, int brightThreshold) {
 	// convert image to grayscale, erode/dilate to reduce noise
 	cv::cvtColor(frame, mask, cv::COLOR_BGR2GRAY);
 	cv::erode(mask, mask, cv::Mat(), cv::Point(-1, -1), 1);
 	cv::dilate(mask, mask, cv::Mat(), cv::Point(-1, -1), 1);
 
 	// do the thresholding
-	cv::threshold(mask, mask, 30, 255, cv::THRESH_BINARY);
+	cv::threshold(mask, mask, brightThreshold, 255, cv::THRESH_BINARY);
 	cv::bitwise_and(frame, frame, masked, mask);
 }
 
@@ -53,86 +63,630 @@ cv::Rect taurus::tracking::findLargestBlob(const cv::Mat& mask, cv::Point2f& cir
 	return cv::boundingRect(contours[largestIndex]);
 }
 
-// private helper function
-static bool findSingleBallHsvMasked(const cv::Mat& hsvMaskedBright, const cv::Mat& mask, taurus::tracking::TrackedObject::PerCameraData& obj) {
-	// optimization - check if there's anything in the image before going straight to color filtering
-	CONTOURLIST_T contours = taurus::tracking::findContours(mask);
-	size_t contourCount = contours.size();
+// minimum amount of color matching pixels for a blob to be considered a ball
+static constexpr int MIN_BALL_PIXELS = 8;
+
+namespace
+{
+	// a ball an object already took in this frame, other objects of the same color leave it alone
+	struct ClaimedBall {
+		cv::Point2f center;
+		taurus::tracking::HsvColorRange color;
+	};
+}
 
-	if (contourCount < 1) {
-		obj.acquiredTracking = false;
-		return false;
+// private helper function
+// global bounds of a blob that contain a ball claimed by an object of this color
+static bool isClaimed(const cv::Rect& bounds, const taurus::tracking::HsvColorRange& color, const std::vector<ClaimedBall>& claimed) {
+	for (const ClaimedBall& ball : claimed) {
+		if (ball.color.lower == color.lower && ball.color.upper == color.upper && cv::Rect2f(bounds).contains(ball.center)) return true;
 	}
+	return false;
+}
 
-	// find new contours after color filtering
-	cv::Mat roiHsvTested;
-	cv::inRange(hsvMaskedBright(obj.roi), obj.color.lower, obj.color.upper, roiHsvTested);
-	contours = taurus::tracking::findContours(roiHsvTested);
-	contourCount = contours.size();
+// private helper function
+// makes the blob (labeled in region coordinates, from the region's class image) the object's detection, and claims its ball
+static void acceptBlob(const cv::Mat& frame, const cv::Mat& classes, const taurus::tracking::BlobStats& blob, int colorIndex, const cv::Rect& region, int brightThreshold, taurus::tracking::CenterEstimator centerEstimator, std::vector<ClaimedBall>& claimed, taurus::tracking::TrackedObject::PerCameraData& obj) {
+	cv::Point regionToRoi = region.tl() - obj.roi.tl();
 
-	// sort by size, and discard bad contours
-	double largestArea = 0.0;
-	int largestIndex = -1;
-	for (int i = 0; i < contourCount; i++) {
-		CONTOUR_T contour = contours[i];
-		cv::Rect bounds = cv::boundingRect(contour);
-		double area = cv::contourArea(contour);
+	// subpixel center, the estimators fall back to the blob centroid on their own
+	cv::Point2f center;
+	float radius;
+	taurus::tracking::estimateBallCenter(frame, classes, region.tl(), blob, centerEstimator, center, radius, brightThreshold);
 
-		// discard bad contours
-		if (area < 8) continue;  // discard very small contours
-		if (std::abs(bounds.width - bounds.height) > (bounds.height / 2)) continue;  // discard oddly shaped contours
+	obj.acquiredTracking = true;
+	obj.globalCircleCenter = center;
+	obj.circleRadius = radius;
+	obj.trackedPixels = blob.colorVotes[colorIndex];
+	obj.inRoiCircleCenter = center - cv::Point2f(obj.roi.tl());
+	obj.inRoiBounds = blob.bounds + regionToRoi;
+	obj.globalBounds = taurus::tracking::roiRectToGlobal(obj.inRoiBounds, obj.roi);
 
-		if (area > largestArea) {
-			largestArea = area;
-			largestIndex = i;
+	obj.roi = taurus::tracking::fitNewRoi(obj.globalCircleCenter);
+	taurus::tracking::clampRoi(frame, obj.roi);
+
+	claimed.push_back({ obj.globalCircleCenter, obj.color });
+}
+
+// private helper function
+// picks the blob with the most votes for the object's color whose centroid lies in the object's roi
+// blobs are labeled in region coordinates, from the region's class image
+static bool assignBlobToObject(const cv::Mat& frame, const cv::Mat& classes, const std::vector<taurus::tracking::BlobStats>& blobs, int colorIndex, const cv::Rect& region, int brightThreshold, taurus::tracking::CenterEstimator centerEstimator, std::vector<ClaimedBall>& claimed, taurus::tracking::TrackedObject::PerCameraData& obj) {
+	cv::Rect2f roiInRegion = obj.roi - region.tl();
+
+	// sort by votes, and discard bad blobs
+	int bestVotes = 0;
+	int bestIndex = -1;
+	for (int i = 0; i < blobs.size(); i++) {
+		const taurus::tracking::BlobStats& blob = blobs[i];
+		int votes = blob.colorVotes[colorIndex];
+
+		// discard bad blobs
+		if (votes < MIN_BALL_PIXELS) continue;  // discard very small blobs
+		if (std::abs(blob.bounds.width - blob.bounds.height) > (blob.bounds.height / 2)) continue;  // discard oddly shaped blobs
+		if (!roiInRegion.contains(blob.centroid)) continue;  // discard blobs of other objects
+		if (!claimed.empty() && isClaimed(blob.bounds + region.tl(), obj.color, claimed)) continue;  // discard balls of other objects with the same color
+
+		if (votes > bestVotes) {
+			bestVotes = votes;
+			bestIndex = i;
 		}
 	}
 
 	// have we found anything?
-	obj.acquiredTracking = (largestIndex != -1);
+	obj.acquiredTracking = (bestIndex != -1);
 	if (obj.acquiredTracking) {
-		cv::Point2f center;
-		float radius;
-		cv::minEnclosingCircle(contours[largestIndex], center, radius);
-		cv::Rect bounds = cv::boundingRect(contours[largestIndex]);
+		acceptBlob(frame, classes, blobs[bestIndex], colorIndex, region, brightThreshold, centerEstimator, claimed, obj);
+	}
+
+	return obj.acquiredTracking;
+}
+
+// raw bayer input settings
+static constexpr int BAYER_THRESHOLD_MARGIN = 4;  // the lookup table rounds to bin centers, so the raw gate is a bit lower than the gray one
+static constexpr int BAYER_CLASSIFY_MARGIN = 2;  // around the bright samples, covers the interpolation and keeps the opening from seeing the window's edge
+static constexpr int BAYER_DEMOSAIC_MARGIN = 2;  // around the classified window, the center estimators look a bit past the blob
+
+namespace
+{
+	// the frame the detector classifies on
+	// raw bayer input is gated on the mosaic first, and only the windows around bright samples are demosaiced into a frame sized canvas
+	struct DetectionFrame {
+		const cv::Mat& bgr;  // the input itself, or the demosaic canvas for raw input
+		const cv::Mat* bayer = nullptr;
+		cv::Mat* canvas = nullptr;
+		taurus::tracking::BayerPattern pattern = taurus::tracking::PS3EYE_BAYER_PATTERN;
+		const cv::Mat* staticLights = nullptr;
+
+		// the part of the window that needs to be classified, ready to be read from bgr
+		// empty if a raw window has nothing at or above the (gray) threshold in it
+		cv::Rect Prepare(const cv::Rect& window, int brightThreshold) const {
+			cv::Rect area = window & taurus::tracking::createFrameRoi(bgr);
+			if (bayer == nullptr) return area;
+
+			// static lights are skipped right here, they aren't even demosaiced
+			cv::Rect bright = taurus::tracking::findBrightBayerBounds(*bayer, area, brightThreshold - BAYER_THRESHOLD_MARGIN, staticLights);
+			if (bright.empty()) return bright;
+
+			taurus::tracking::increaseRoiSize(bright, BAYER_CLASSIFY_MARGIN * 2);
+			bright &= area;
+
+			cv::Rect demosaiced = bright;
+			taurus::tracking::increaseRoiSize(demosaiced, BAYER_DEMOSAIC_MARGIN * 2);
+			taurus::tracking::demosaicWindow(*bayer, demosaiced, pattern, *canvas);
+			return bright;
+		}
+
+		// clears the static lights out of the classes of an area, before they're labeled
+		void Suppress(const cv::Rect& area, cv::Mat& classes) const {
+			if (staticLights != nullptr) classes.setTo(cv::Scalar::all(0), (*staticLights)(area));
+		}
+	};
+}
+
+// incremental tracking settings
+static constexpr int FULL_DETECTION_INTERVAL = 10;  // frames a ball is tracked incrementally before it's labeled in full again
+static constexpr int MEAN_SHIFT_ITERATIONS = 5;
+static constexpr float MEAN_SHIFT_WINDOW_SCALE = 1.5f;  // half size of the window in ball radii, it holds the whole ball and some dark around it
+static constexpr int MEAN_SHIFT_WINDOW_MARGIN = 2;  // extra pixels of the window, small balls are still fitted on their edge
+static constexpr float MIN_TRACKED_PIXEL_RATIO = 0.6f;  // a ball whose pixel count changed by more than this factor (either way) since the last frame is labeled in full
+
+// private helper function
+// follows a ball found in the previous frame from its predicted (or previous) center, with a few mean-shift iterations on a small classified window
+// the object is only changed if the ball was found with confidence, otherwise it is labeled in full like any other
+static bool trackIncrementally(const DetectionFrame& frame, const taurus::tracking::ColorLut* colorLut, int objectIndex, taurus::tracking::CenterEstimator centerEstimator, std::vector<ClaimedBall>& claimed, taurus::tracking::TrackedObject::PerCameraData& obj) {
+	thread_local std::vector<taurus::tracking::HsvColorRange> colors(1);
+	thread_local cv::Mat classes;
+
+	if (obj.trackedPixels < MIN_BALL_PIXELS) return false;
 
-		obj.inRoiCircleCenter = center;
-		obj.circleRadius = radius;
-		obj.inRoiBounds = bounds;
-		obj.globalCircleCenter = taurus::tracking::roiPointToGlobal(center, obj.roi);
-		obj.globalBounds = taurus::tracking::roiRectToGlobal(bounds, obj.roi);
+	// the window can move about a ball radius from where the ball is expected
+	cv::Point2f start = obj.hasPrediction ? obj.predictedCenter : obj.globalCircleCenter;
+	float halfSize = obj.circleRadius * MEAN_SHIFT_WINDOW_SCALE + MEAN_SHIFT_WINDOW_MARGIN;
+	int searchHalf = static_cast<int>(std::ceil(halfSize + obj.circleRadius));
+	cv::Rect search = cv::Rect(cvRound(start.x) - searchHalf, cvRound(start.y) - searchHalf, searchHalf * 2 + 1, searchHalf * 2 + 1);
 
-		obj.roi = taurus::tracking::fitNewRoi(obj.globalCircleCenter);
-		taurus::tracking::clampRoi(hsvMaskedBright, obj.roi);
+	int brightThreshold = obj.brightness.threshold;
+	cv::Rect area = frame.Prepare(search, brightThreshold);
+	if (area.empty()) return false;
+
+	// the table's color bits are in object order
+	int colorIndex = 0;
+	if (colorLut != nullptr) {
+		taurus::tracking::classifyRoi(frame.bgr, area, *colorLut, classes, brightThreshold);
+		colorIndex = objectIndex;
+	}
+	else {
+		colors[0] = obj.color;
+		taurus::tracking::classifyRoi(frame.bgr, area, colors, classes, brightThreshold);
 	}
+	frame.Suppress(area, classes);
 
-	return obj.acquiredTracking;
+	taurus::tracking::MeanShiftResult result;
+	if (!taurus::tracking::meanShiftBlob(classes, colorIndex, start - cv::Point2f(area.tl()), halfSize, MEAN_SHIFT_ITERATIONS, result)) return false;
+
+	// a blob running into the window's edge is bigger than the ball, or cut off by the search area
+	const cv::Rect& bounds = result.bounds;
+	const cv::Rect& window = result.window;
+	if (bounds.x == window.x || bounds.y == window.y || bounds.br().x == window.br().x || bounds.br().y == window.br().y) return false;
+
+	// the same checks as a labeled blob, and about as many pixels as in the last frame
+	float pixelRatio = static_cast<float>(result.area) / obj.trackedPixels;
+	if (result.area < MIN_BALL_PIXELS || pixelRatio < MIN_TRACKED_PIXEL_RATIO || pixelRatio > 1.f / MIN_TRACKED_PIXEL_RATIO) return false;
+	if (std::abs(bounds.width - bounds.height) > (bounds.height / 2)) return false;
+	if (!claimed.empty() && isClaimed(bounds + area.tl(), obj.color, claimed)) return false;
+
+	taurus::tracking::BlobStats blob;
+	blob.area = result.area;
+	blob.bounds = bounds;
+	blob.centroid = result.centroid;
+	blob.colorVotes[colorIndex] = result.area;
+
+	acceptBlob(frame.bgr, classes, blob, colorIndex, area, brightThreshold, centerEstimator, claimed, obj);
+	return true;
 }
 
-bool taurus::tracking::findSingleBall(const cv::Mat& frame, TrackedObject& obj, int cameraIndex) {
-	cv::Mat hsvMaskedFrame, maskedFrame, mask;
-	maskBrightBlobs(frame, maskedFrame, mask);
-	cv::cvtColor(maskedFrame, hsvMaskedFrame, cv::COLOR_BGR2HSV);
+// coarse search settings for lost objects
+static constexpr int MIN_COARSE_PIXELS = 2;  // a small ball is only a couple of pixels wide on the downsampled frame
+static constexpr int MAX_REACQUIRE_CANDIDATES = 3;  // candidates per object that get refined at full resolution
+static constexpr int REACQUIRE_MARGIN = 2;  // extra downsampled pixels around a candidate, covers the dim edge the area filter blends away
+
+// private helper function
+// refines a single candidate (full resolution rect) of a lost object, the object keeps the candidate as its roi while it's refined
+static bool refineCandidate(const DetectionFrame& frame, const cv::Rect& candidate, taurus::tracking::CenterEstimator centerEstimator, std::vector<ClaimedBall>& claimed, taurus::tracking::TrackedObject::PerCameraData& obj) {
+	thread_local std::vector<taurus::tracking::HsvColorRange> colors(1);
+	thread_local std::vector<taurus::tracking::BlobStats> blobs;
+	thread_local cv::Mat classes;
 
-	return findSingleBallHsvMasked(hsvMaskedFrame, mask, obj.perCameraData[cameraIndex]);
+	obj.roi = candidate & taurus::tracking::createFrameRoi(frame.bgr);
+	if (obj.roi.empty()) return false;
+
+	int brightThreshold = obj.brightness.threshold;
+	cv::Rect area = frame.Prepare(obj.roi, brightThreshold);
+	if (area.empty()) return false;
+
+	colors[0] = obj.color;
+	taurus::tracking::classifyRoi(frame.bgr, area, colors, classes, brightThreshold);
+	frame.Suppress(area, classes);
+	taurus::tracking::labelBlobs(classes, blobs, MIN_BALL_PIXELS);
+
+	return assignBlobToObject(frame.bgr, classes, blobs, 0, area, brightThreshold, centerEstimator, claimed, obj);
 }
 
-void taurus::tracking::findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject>& objects, int cameraIndex) {
-	cv::Mat hsvMaskedFrame, maskedFrame, mask;
-	maskBrightBlobs(frame, maskedFrame, mask);
-	cv::cvtColor(maskedFrame, hsvMaskedFrame, cv::COLOR_BGR2HSV);
+// private helper function
+// coarse to fine reacquisition of lost objects, all in the current frame
+// the frame is downsampled once and searched for every lost color, then only the best few candidates of each object are refined at full resolution
+// objects without any candidate (or whose candidates all fail) keep the whole frame as their roi and stay lost
+static void reacquireObjects(const DetectionFrame& frame, std::vector<taurus::tracking::TrackedObject::PerCameraData*>& lost, int scale, taurus::tracking::CenterEstimator centerEstimator, std::vector<ClaimedBall>& claimed) {
+	thread_local cv::Mat binnedFrame;
+	thread_local cv::Mat smallFrame;
+	thread_local cv::Mat smallStaticLights;
+	thread_local cv::Mat classes;
+	thread_local std::vector<taurus::tracking::HsvColorRange> colors;
+	thread_local std::vector<taurus::tracking::BlobStats> blobs;
+	thread_local std::vector<int> candidates;
 
-	for (TrackedObject& obj : objects) {
-		bool found = findSingleBallHsvMasked(hsvMaskedFrame, mask, obj.perCameraData[cameraIndex]);
+	// the area filter averages the noise away, so the coarse pass doesn't need the opening
+	// raw input is binned into half resolution color first, which is the first halving for free
+	if (frame.bayer != nullptr) {
+		taurus::tracking::binBayer(*frame.bayer, frame.pattern, binnedFrame);
+		if (scale > 2) {
+			double factor = 2.0 / scale;
+			cv::resize(binnedFrame, smallFrame, cv::Size(), factor, factor, cv::INTER_AREA);
+		}
+		else {
+			binnedFrame.copyTo(smallFrame);
+		}
+	}
+	else {
+		double factor = 1.0 / scale;
+		cv::resize(frame.bgr, smallFrame, cv::Size(), factor, factor, cv::INTER_AREA);
+	}
+	cv::Rect smallRoi = taurus::tracking::createFrameRoi(smallFrame);
+
+	// a downsampled pixel is skipped if it's mostly static light
+	if (frame.staticLights != nullptr) {
+		cv::resize(*frame.staticLights, smallStaticLights, smallFrame.size(), 0.0, 0.0, cv::INTER_AREA);
+		cv::threshold(smallStaticLights, smallStaticLights, 127, 255, cv::THRESH_BINARY);
+	}
+
+	for (size_t first = 0; first < lost.size(); first += taurus::tracking::MAX_SEGMENT_COLORS) {
+		size_t count = std::min(taurus::tracking::MAX_SEGMENT_COLORS, lost.size() - first);
+
+		// the most permissive gate of the batch, so no object's ball is gated away
+		colors.clear();
+		int brightThreshold = taurus::tracking::MAX_BRIGHT_THRESHOLD;
+		for (size_t i = 0; i < count; i++) {
+			colors.push_back(lost[first + i]->color);
+			brightThreshold = std::min(brightThreshold, lost[first + i]->brightness.threshold);
+		}
+
+		taurus::tracking::classifyRoiUnopened(smallFrame, smallRoi, colors, classes, brightThreshold);
+		if (frame.staticLights != nullptr) classes.setTo(cv::Scalar::all(0), smallStaticLights);
+		taurus::tracking::labelBlobs(classes, blobs, MIN_COARSE_PIXELS);
+
+		for (size_t i = 0; i < count; i++) {
+			taurus::tracking::TrackedObject::PerCameraData* obj = lost[first + i];
+			int colorIndex = static_cast<int>(i);
+
+			// best candidates first, by how many pixels voted for this object's color
+			candidates.clear();
+			for (int b = 0; b < blobs.size(); b++) {
+				if (blobs[b].colorVotes[colorIndex] >= MIN_COARSE_PIXELS) candidates.push_back(b);
+			}
+			std::sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+				return blobs[a].colorVotes[colorIndex] > blobs[b].colorVotes[colorIndex];
+			});
+			if (candidates.size() > MAX_REACQUIRE_CANDIDATES) candidates.resize(MAX_REACQUIRE_CANDIDATES);
+
+			bool found = false;
+			for (int b : candidates) {
+				cv::Rect coarse = blobs[b].bounds;
+				cv::Rect candidate = cv::Rect(
+					(coarse.x - REACQUIRE_MARGIN) * scale,
+					(coarse.y - REACQUIRE_MARGIN) * scale,
+					(coarse.width + REACQUIRE_MARGIN * 2) * scale,
+					(coarse.height + REACQUIRE_MARGIN * 2) * scale
+				);
+
+				if (refineCandidate(frame, candidate, centerEstimator, claimed, *obj)) {
+					found = true;
+					break;
+				}
+			}
+
+			if (!found) {
+				obj->acquiredTracking = false;
+				obj->roi = taurus::tracking::createFrameRoi(frame.bgr);
+			}
+		}
+	}
+}
+
+// frame-level assignment settings, the costs are in pixels
+static constexpr float ASSIGNMENT_GATE = 400.f;  // only the hard gates reject a pair, every pair passing them costs less than this
+static constexpr float COLOR_COST = 20.f;  // for a blob none of whose pixels pass the object's color range, scaled by the fraction that doesn't
+static constexpr float RADIUS_COST = 2.f;  // per pixel of radius difference to the object's previous detection
+static constexpr float MAX_RADIUS_RATIO = 2.5f;  // a blob this much bigger or smaller than the object's previous detection is another ball
+static constexpr float SIZE_COST = 40.f;  // objects without an expected position prefer their largest blob, for a blob with none of its votes
+
+namespace
+{
+	// one classification and labeling pass over a region, for up to MAX_SEGMENT_COLORS of its objects
+	struct ClassPass {
+		cv::Rect area = {};
+		int brightThreshold = 0;
+		int firstBlob = 0;
+		int blobCount = 0;
+	};
+
+	// a labeled blob of a pass, blobs seen by several passes (overlapping regions) share their column of the assignment
+	struct FrameBlob {
+		taurus::tracking::BlobStats stats = {};
+		cv::Rect globalBounds = {};
+		cv::Point2f globalCentroid = {};
+		int column = 0;
+	};
+
+	// an object searched by a pass, colorIndex is its color bit in the pass' class image
+	struct AssignmentRow {
+		size_t object = 0;
+		int pass = 0;
+		int colorIndex = 0;
+	};
+}
+
+// private helper function
+// adds a pass over the area, its class image is kept (and reused across frames) until the blobs are assigned
+static int addClassPass(const cv::Rect& area, int brightThreshold, std::vector<ClassPass>& passes, std::vector<cv::Mat>& passClasses) {
+	ClassPass& pass = passes.emplace_back();
+	pass.area = area;
+	pass.brightThreshold = brightThreshold;
+	if (passClasses.size() < passes.size()) passClasses.emplace_back();
+	return static_cast<int>(passes.size()) - 1;
+}
+
+// private helper function
+// labels a classified pass, and gives every blob its column, a new one unless an earlier pass has the same blob
+static void labelClassPass(const DetectionFrame& frame, int passIndex, std::vector<ClassPass>& passes, std::vector<cv::Mat>& passClasses, std::vector<FrameBlob>& frameBlobs, int& columns) {
+	thread_local std::vector<taurus::tracking::BlobStats> blobs;
+
+	ClassPass& pass = passes[passIndex];
+	frame.Suppress(pass.area, passClasses[passIndex]);
+	taurus::tracking::labelBlobs(passClasses[passIndex], blobs, MIN_BALL_PIXELS);
+
+	pass.firstBlob = static_cast<int>(frameBlobs.size());
+	pass.blobCount = static_cast<int>(blobs.size());
+	for (const taurus::tracking::BlobStats& stats : blobs) {
+		FrameBlob blob;
+		blob.stats = stats;
+		blob.globalBounds = stats.bounds + pass.area.tl();
+		blob.globalCentroid = stats.centroid + cv::Point2f(pass.area.tl());
+		blob.column = -1;
+
+		for (int i = 0; i < pass.firstBlob && blob.column < 0; i++) {
+			const FrameBlob& other = frameBlobs[i];
+			if (cv::Rect2f(other.globalBounds).contains(blob.globalCentroid) && cv::Rect2f(blob.globalBounds).contains(other.globalCentroid)) blob.column = other.column;
+		}
+		if (blob.column < 0) blob.column = columns++;
+
+		frameBlobs.push_back(blob);
+	}
+}
+
+// private helper function
+// cost of giving a blob (of the object's pass) to the object, more than the gate if the blob can't be its ball
+// the blob has to pass the same checks as before, and then costs its distance from where the ball is expected, plus its color and size mismatch
+static float blobCost(const taurus::tracking::TrackedObject::PerCameraData& obj, const FrameBlob& blob, int colorIndex, int largestVotes, const std::vector<ClaimedBall>& claimed) {
+	const taurus::tracking::BlobStats& stats = blob.stats;
+	int votes = stats.colorVotes[colorIndex];
+
+	// discard bad blobs
+	if (votes < MIN_BALL_PIXELS) return ASSIGNMENT_GATE + 1.f;  // discard very small blobs
+	if (std::abs(stats.bounds.width - stats.bounds.height) > (stats.bounds.height / 2)) return ASSIGNMENT_GATE + 1.f;  // discard oddly shaped blobs
+	if (!cv::Rect2f(obj.roi).contains(blob.globalCentroid)) return ASSIGNMENT_GATE + 1.f;  // discard blobs of other objects
+	if (!claimed.empty() && isClaimed(blob.globalBounds, obj.color, claimed)) return ASSIGNMENT_GATE + 1.f;  // discard balls claimed outside the assignment
+
+	float cost = COLOR_COST * (1.f - static_cast<float>(votes) / stats.area);
+
+	// the previous detection's size is only known while the object is tracked
+	float radius = stats.equivalentRadius();
+	if (obj.acquiredTracking && obj.circleRadius > 0.f) {
+		float ratio = radius / obj.circleRadius;
+		if (ratio > MAX_RADIUS_RATIO || ratio < 1.f / MAX_RADIUS_RATIO) return ASSIGNMENT_GATE + 1.f;
+		cost += RADIUS_COST * std::abs(radius - obj.circleRadius);
+	}
+
+	if (obj.hasPrediction) cost += static_cast<float>(cv::norm(blob.globalCentroid - obj.predictedCenter));
+	else if (obj.acquiredTracking) cost += static_cast<float>(cv::norm(blob.globalCentroid - obj.globalCircleCenter));
+	else cost += SIZE_COST * (1.f - static_cast<float>(votes) / largestVotes);
+
+	return std::min(cost, ASSIGNMENT_GATE);
+}
+
+// private helper function
+// assigns the blobs of every pass to the objects that searched them, all at once (gated minimum cost, see solveGatedAssignment)
+// a blob goes to one object at most, even if the rois of several objects (of any color) overlap on it
+static void assignBlobsToObjects(const cv::Mat& frame, std::vector<taurus::tracking::TrackedObject::PerCameraData*>& objects, const std::vector<ClassPass>& passes, const std::vector<cv::Mat>& passClasses, const std::vector<FrameBlob>& frameBlobs, const std::vector<AssignmentRow>& rows, int columns, taurus::tracking::CenterEstimator centerEstimator, std::vector<ClaimedBall>& claimed) {
+	thread_local std::vector<float> costs;
+	thread_local std::vector<int> assignment;
+
+	int rowCount = static_cast<int>(rows.size());
+	costs.assign(static_cast<size_t>(rowCount) * columns, ASSIGNMENT_GATE + 1.f);
+	for (int r = 0; r < rowCount; r++) {
+		const AssignmentRow& row = rows[r];
+		const ClassPass& pass = passes[row.pass];
+		const taurus::tracking::TrackedObject::PerCameraData& obj = *objects[row.object];
+
+		int largestVotes = 1;
+		for (int b = pass.firstBlob; b < pass.firstBlob + pass.blobCount; b++) {
+			largestVotes = std::max(largestVotes, frameBlobs[b].stats.colorVotes[row.colorIndex]);
+		}
+		for (int b = pass.firstBlob; b < pass.firstBlob + pass.blobCount; b++) {
+			float& cost = costs[r * columns + frameBlobs[b].column];
+			cost = std::min(cost, blobCost(obj, frameBlobs[b], row.colorIndex, largestVotes, claimed));
+		}
+	}
+	taurus::tracking::solveGatedAssignment(costs, rowCount, columns, ASSIGNMENT_GATE, assignment);
+
+	for (int r = 0; r < rowCount; r++) {
+		const AssignmentRow& row = rows[r];
+		const ClassPass& pass = passes[row.pass];
+		taurus::tracking::TrackedObject::PerCameraData& obj = *objects[row.object];
+
+		// the assigned column's blob as this object's pass labeled it
+		int bestBlob = -1;
+		for (int b = pass.firstBlob; b < pass.firstBlob + pass.blobCount && assignment[r] >= 0; b++) {
+			if (frameBlobs[b].column == assignment[r]) bestBlob = b;
+		}
+
+		obj.acquiredTracking = bestBlob >= 0;
+		if (obj.acquiredTracking) {
+			acceptBlob(frame, passClasses[row.pass], frameBlobs[bestBlob].stats, row.colorIndex, pass.area, pass.brightThreshold, centerEstimator, claimed, obj);
+		}
+	}
+}
+
+// private helper function
+// plans the segmentation regions for every tracked object on this camera, and labels every region once for all of its objects
+// the blobs of all regions are then assigned to the objects in one go
+// lost objects without a predicted roi are reacquired with a coarse to fine search, unless that is turned off, in which case they search the whole frame
+// if a color lookup table built for exactly these objects (in this order) is given, it replaces the hsv conversion
+// raw bayer frames (CV_8UC1) are only demosaiced in the parts of the regions that have something bright in them
+static void findBallsInRegions(const cv::Mat& input, std::vector<taurus::tracking::TrackedObject::PerCameraData*>& objects, const taurus::tracking::DetectorOptions& options) {
+	thread_local std::vector<size_t> searched;
+	thread_local std::vector<taurus::tracking::TrackedObject::PerCameraData*> lost;
+	thread_local std::vector<cv::Rect> rois;
+	thread_local std::vector<taurus::tracking::SegmentRegion> regions;
+	thread_local std::vector<taurus::tracking::HsvColorRange> colors;
+	thread_local std::vector<ClassPass> passes;
+	thread_local std::vector<cv::Mat> passClasses;
+	thread_local std::vector<FrameBlob> frameBlobs;
+	thread_local std::vector<AssignmentRow> rows;
+	thread_local cv::Mat demosaiced;
+	thread_local std::vector<ClaimedBall> claimed;
+
+	bool isBayer = input.type() == CV_8UC1;
+	if (isBayer && (demosaiced.size() != input.size() || demosaiced.type() != CV_8UC3)) {
+		demosaiced.create(input.size(), CV_8UC3);
+		demosaiced.setTo(cv::Scalar::all(0));
+	}
+
+	DetectionFrame detectionFrame = { isBayer ? demosaiced : input };
+	if (isBayer) {
+		detectionFrame.bayer = &input;
+		detectionFrame.canvas = &demosaiced;
+		detectionFrame.pattern = options.bayerPattern;
+	}
+	if (options.staticLights != nullptr && !options.staticLights->empty() && options.staticLights->size() == input.size()) {
+		detectionFrame.staticLights = options.staticLights;
+	}
+	const cv::Mat& frame = detectionFrame.bgr;
+
+	const taurus::tracking::ColorLut* colorLut = options.colorLut;
+	bool useLut = colorLut != nullptr && colorLut->IsBuilt() && colorLut->GetColorCount() == objects.size();
+
+	bool reacquire = options.reacquireScale > 1;
+	bool wholeFrame = false;
+	claimed.clear();
+	searched.clear();
+	lost.clear();
+	rois.clear();
+	for (size_t i = 0; i < objects.size(); i++) {
+		taurus::tracking::TrackedObject::PerCameraData* obj = objects[i];
+		bool isLost = !obj->acquiredTracking && !obj->roiPredicted;
+		obj->roiPredicted = false;
+		obj->incrementalDetection = false;
+
+		// a ball at rest keeps its detection, it still claims its ball for the other objects of its color
+		obj->reusedDetection = options.motionGating && taurus::tracking::isBallAtRest(input, *obj);
+		if (obj->reusedDetection) {
+			obj->reusedFrames++;
+			claimed.push_back({ obj->globalCircleCenter, obj->color });
+			continue;
+		}
+
+		// a ball found in the previous frame is followed from there, and only labeled in full every few frames or when that fails
+		obj->incrementalDetection = options.incrementalTracking && obj->acquiredTracking && obj->incrementalFrames < FULL_DETECTION_INTERVAL &&
+			trackIncrementally(detectionFrame, useLut ? colorLut : nullptr, static_cast<int>(i), options.centerEstimator, claimed, *obj);
+		if (obj->incrementalDetection) {
+			obj->incrementalFrames++;
+			continue;
+		}
+		obj->incrementalFrames = 0;
+
+		if (isLost && reacquire) {
+			lost.push_back(obj);
+			continue;
+		}
+		if (isLost) {
+			obj->roi = taurus::tracking::createFrameRoi(frame);
+			wholeFrame = true;
+		}
+		searched.push_back(i);
+		rois.push_back(obj->roi);
+	}
+
+	taurus::tracking::planRegions(frame, rois, wholeFrame, regions);
+
+	// every region is classified and labeled once, and all of its blobs go into a single assignment for the whole frame
+	passes.clear();
+	frameBlobs.clear();
+	rows.clear();
+	int columns = 0;
+	for (const taurus::tracking::SegmentRegion& region : regions) {
+		// objects sharing a region share its gate, the most permissive one of them
+		int brightThreshold = taurus::tracking::MAX_BRIGHT_THRESHOLD;
+		for (size_t member : region.members) {
+			brightThreshold = std::min(brightThreshold, objects[searched[member]]->brightness.threshold);
+		}
+
+		// a region without anything bright in it has no blobs, its objects just lose tracking
+		cv::Rect area = detectionFrame.Prepare(region.bounds, brightThreshold);
+		bool hasBright = !area.empty();
+		if (!hasBright) area = region.bounds;
+
+		if (useLut) {
+			// the table already has every object's color, one pass for the whole region
+			int pass = addClassPass(area, brightThreshold, passes, passClasses);
+			if (hasBright) {
+				taurus::tracking::classifyRoi(frame, area, *colorLut, passClasses[pass], brightThreshold);
+				labelClassPass(detectionFrame, pass, passes, passClasses, frameBlobs, columns);
+			}
+
+			for (size_t member : region.members) {
+				// the table's color bits are in object order
+				size_t objectIndex = searched[member];
+				objects[objectIndex]->roi &= region.bounds;
+				rows.push_back({ objectIndex, pass, static_cast<int>(objectIndex) });
+			}
+			continue;
+		}
+
+		// a single segmentation pass can only test so many colors at once
+		for (size_t first = 0; first < region.members.size(); first += taurus::tracking::MAX_SEGMENT_COLORS) {
+			size_t count = std::min(taurus::tracking::MAX_SEGMENT_COLORS, region.members.size() - first);
+
+			colors.clear();
+			for (size_t i = 0; i < count; i++) {
+				colors.push_back(objects[searched[region.members[first + i]]]->color);
+			}
+
+			// one classification and one labeling pass for every object in the region
+			int pass = addClassPass(area, brightThreshold, passes, passClasses);
+			if (hasBright) {
+				taurus::tracking::classifyRoi(frame, area, colors, passClasses[pass], brightThreshold);
+				labelClassPass(detectionFrame, pass, passes, passClasses, frameBlobs, columns);
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				size_t objectIndex = searched[region.members[first + i]];
+				objects[objectIndex]->roi &= region.bounds;
+				rows.push_back({ objectIndex, pass, static_cast<int>(i) });
+			}
+		}
+	}
+
+	assignBlobsToObjects(frame, objects, passes, passClasses, frameBlobs, rows, columns, options.centerEstimator, claimed);
+
+	// only after every tracked object claimed its ball, so a lost object can't take one of them for its own
+	if (!lost.empty()) {
+		reacquireObjects(detectionFrame, lost, options.reacquireScale, options.centerEstimator, claimed);
+	}
+
+	// adapt every freshly found ball's gate to its next roi, and keep its surroundings for the motion gate, on the input itself (raw samples for bayer input)
+	for (taurus::tracking::TrackedObject::PerCameraData* obj : objects) {
+		if (obj->reusedDetection) continue;
+
+		if (obj->acquiredTracking) taurus::tracking::updateAdaptiveThreshold(input, obj->roi, obj->circleRadius, obj->brightness);
+		if (options.motionGating) taurus::tracking::captureRestPatch(input, *obj);
 	}
 }
 
-void taurus::tracking::findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject*>& objects, int cameraIndex) {
-	cv::Mat hsvMaskedFrame, maskedFrame, mask;
-	maskBrightBlobs(frame, maskedFrame, mask);
-	cv::cvtColor(maskedFrame, hsvMaskedFrame, cv::COLOR_BGR2HSV);
+bool taurus::tracking::findSingleBall(const cv::Mat& frame, TrackedObject& obj, int cameraIndex) {
+	thread_local std::vector<TrackedObject::PerCameraData*> cameraData;
+	cameraData.assign(1, &obj.perCameraData[cameraIndex]);
+
+	findBallsInRegions(frame, cameraData, DetectorOptions());
+	return obj.perCameraData[cameraIndex].acquiredTracking;
+}
 
+void taurus::tracking::findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject>& objects, int cameraIndex, const DetectorOptions& options) {
+	thread_local std::vector<TrackedObject::PerCameraData*> cameraData;
+	cameraData.clear();
+	for (TrackedObject& obj : objects) {
+		cameraData.push_back(&obj.perCameraData[cameraIndex]);
+	}
+
+	findBallsInRegions(frame, cameraData, options);
+}
+
+void taurus::tracking::findMultiBalls(const cv::Mat& frame, std::vector<TrackedObject*>& objects, int cameraIndex, const DetectorOptions& options) {
+	thread_local std::vector<TrackedObject::PerCameraData*> cameraData;
+	cameraData.clear();
 	for (TrackedObject* obj : objects) {
-		bool found = findSingleBallHsvMasked(hsvMaskedFrame, mask, obj->perCameraData[cameraIndex]);
+		cameraData.push_back(&obj->perCameraData[cameraIndex]);
 	}
+
+	findBallsInRegions(frame, cameraData, options);
 }
@@ -0,0 +1,87 @@
+#include "core/tracking/mean_shift.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+// the window has settled once it moves less than this (pixels)
+static constexpr float MEAN_SHIFT_CONVERGENCE = 0.5f;
+
+namespace
+{
+	// the ball's pixels in a window
+	struct WindowMoments {
+		int area = 0;
+		int64_t sumX = 0;
+		int64_t sumY = 0;
+		int minX = INT_MAX;
+		int minY = INT_MAX;
+		int maxX = -1;
+		int maxY = -1;
+	};
+}
+
+// private helper function
+// square window of the given half size around a center, clipped to the class image
+static cv::Rect windowAt(const cv::Mat& classes, const cv::Point2f& center, float halfSize) {
+	int half = static_cast<int>(std::ceil(halfSize));
+	cv::Rect window = cv::Rect(cvRound(center.x) - half, cvRound(center.y) - half, half * 2 + 1, half * 2 + 1);
+	return window & cv::Rect(0, 0, classes.cols, classes.rows);
+}
+
+// private helper function
+static WindowMoments windowMoments(const cv::Mat& classes, const cv::Rect& window, uchar colorBit) {
+	WindowMoments moments;
+	for (int y = window.y; y < window.y + window.height; y++) {
+		const uchar* row = classes.ptr<uchar>(y);
+		for (int x = window.x; x < window.x + window.width; x++) {
+			uchar c = row[x];
+			if (!(c & taurus::tracking::CLASS_BRIGHT_BIT) || !(c & colorBit)) continue;
+
+			moments.area++;
+			moments.sumX += x;
+			moments.sumY += y;
+			moments.minX = std::min(moments.minX, x);
+			moments.minY = std::min(moments.minY, y);
+			moments.maxX = std::max(moments.maxX, x);
+			moments.maxY = std::max(moments.maxY, y);
+		}
+	}
+	return moments;
+}
+
+bool taurus::tracking::meanShiftBlob(const cv::Mat& classes, int colorIndex, const cv::Point2f& start, float halfSize, int maxIterations, MeanShiftResult& result) {
+	result = MeanShiftResult();
+	if (classes.empty() || colorIndex < 0 || colorIndex >= static_cast<int>(MAX_SEGMENT_COLORS)) return false;
+
+	uchar colorBit = static_cast<uchar>(1 << colorIndex);
+	cv::Point2f center = start;
+	WindowMoments moments;
+	cv::Rect window;
+
+	for (int iteration = 0; iteration < maxIterations && !result.converged; iteration++) {
+		window = windowAt(classes, center, halfSize);
+		if (window.empty()) return false;
+
+		moments = windowMoments(classes, window, colorBit);
+		result.iterations++;
+		if (moments.area == 0) return false;
+
+		cv::Point2f centroid = cv::Point2f(static_cast<float>(moments.sumX) / moments.area, static_cast<float>(moments.sumY) / moments.area);
+		result.converged = cv::norm(centroid - center) < MEAN_SHIFT_CONVERGENCE;
+		center = centroid;
+	}
+	if (!result.converged) return false;
+
+	// the moments of the window the ball settled in
+	window = windowAt(classes, center, halfSize);
+	moments = windowMoments(classes, window, colorBit);
+	if (moments.area == 0) return false;
+
+	result.window = window;
+	result.area = moments.area;
+	result.centroid = cv::Point2f(static_cast<float>(moments.sumX) / moments.area, static_cast<float>(moments.sumY) / moments.area);
+	result.bounds = cv::Rect(moments.minX, moments.minY, moments.maxX - moments.minX + 1, moments.maxY - moments.minY + 1);
+	return true;
+}
@@ -0,0 +1,111 @@
+#include "core/tracking/motion_gate.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TAURUS_SAD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TAURUS_SAD_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TAURUS_SAD_NEON
+#endif
+
+// pixels around the ball's bounds that are compared, a moving ball changes its edge first
+static constexpr int REST_PATCH_MARGIN = 4;
+// mean absolute difference per byte a ball at rest stays below, a tenth of a pixel of motion already changes the edge by more
+static constexpr float REST_MEAN_DIFFERENCE = 1.f;
+// a resting ball is detected in full again after this many reused frames, so it never rests on a stale result for long
+static constexpr int MAX_REUSED_FRAMES = 60;
+
+uint64_t taurus::tracking::sumAbsDiff(const uchar* a, const uchar* b, int count) {
+	uint64_t sum = 0;
+	int i = 0;
+
+#if defined(TAURUS_SAD_AVX2)
+	__m256i acc = _mm256_setzero_si256();
+	for (; i + 32 <= count; i += 32) {
+		__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+	}
+	alignas(32) uint64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+	sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(TAURUS_SAD_SSE)
+	__m128i acc = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+	}
+	alignas(16) uint64_t lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+	sum = lanes[0] + lanes[1];
+#elif defined(TAURUS_SAD_NEON)
+	// 16 bit pairwise sums into 32 bit lanes, a patch is far too small to overflow them
+	uint32x4_t acc = vdupq_n_u32(0);
+	for (; i + 16 <= count; i += 16) {
+		uint8x16_t difference = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+		acc = vpadalq_u16(acc, vpaddlq_u8(difference));
+	}
+	sum = static_cast<uint64_t>(vgetq_lane_u32(acc, 0)) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+
+	// leftover bytes at the end
+	for (; i < count; i++) {
+		sum += static_cast<uint64_t>(std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+	}
+	return sum;
+}
+
+bool taurus::tracking::isBallAtRest(const cv::Mat& frame, const TrackedObject::PerCameraData& data) {
+	const cv::Mat& patch = data.restPatch;
+	const cv::Rect& rect = data.restRect;
+	if (!data.acquiredTracking || patch.empty() || rect.empty()) return false;
+	if (data.reusedFrames >= MAX_REUSED_FRAMES) return false;
+	if (patch.type() != frame.type() || patch.size() != rect.size()) return false;
+	if ((rect & createFrameRoi(frame)) != rect) return false;
+
+	int rowBytes = rect.width * static_cast<int>(frame.elemSize());
+	uint64_t limit = static_cast<uint64_t>(REST_MEAN_DIFFERENCE * static_cast<float>(rowBytes) * static_cast<float>(rect.height));
+	uint64_t sum = 0;
+	for (int y = 0; y < rect.height; y++) {
+		sum += sumAbsDiff(frame.ptr<uchar>(rect.y + y) + rect.x * frame.elemSize(), patch.ptr<uchar>(y), rowBytes);
+
+		// moving balls usually give up within the first rows
+		if (sum > limit) return false;
+	}
+	return true;
+}
+
+void taurus::tracking::captureRestPatch(const cv::Mat& frame, TrackedObject::PerCameraData& data) {
+	data.reusedFrames = 0;
+	if (!data.acquiredTracking) {
+		data.restRect = cv::Rect();
+		return;
+	}
+
+	data.restRect = data.globalBounds;
+	increaseRoiSize(data.restRect, REST_PATCH_MARGIN * 2);
+	data.restRect &= createFrameRoi(frame);
+	if (data.restRect.empty()) return;
+
+	// copyTo keeps the patch's buffer while the ball's size stays the same
+	frame(data.restRect).copyTo(data.restPatch);
+}
+
+const char* taurus::tracking::motionGateKernelName() {
+#if defined(TAURUS_SAD_AVX2)
+	return "AVX2";
+#elif defined(TAURUS_SAD_SSE)
+	return "SSE2";
+#elif defined(TAURUS_SAD_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,247 @@
+#include "core/tracking/multiview.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/tracking/roi_prediction.h"
+#include "core/tracking/time_alignment.h"
+
+// error of a detected ball radius, pixels plus a fraction of the radius (blur, the glow and partial occlusion all change it)
+static constexpr float MONOCULAR_RADIUS_ERROR_PX = 0.5f;
+static constexpr float MONOCULAR_RADIUS_ERROR_FRACTION = 0.05f;
+// balls smaller than this (pixels) are too small to tell their distance
+static constexpr float MIN_MONOCULAR_RADIUS = 2.f;
+
+taurus::tracking::TriangulationCamera taurus::tracking::createTriangulationCamera(const cv::Mat& P, double pixelScale) {
+	TriangulationCamera camera;
+	camera.pixelScale = pixelScale;
+	if (P.rows != 3 || P.cols != 4) return camera;
+
+	cv::Mat P64;
+	P.convertTo(P64, CV_64F);
+	for (int r = 0; r < 3; r++) {
+		for (int c = 0; c < 4; c++) {
+			camera.P(r, c) = P64.at<double>(r, c);
+		}
+	}
+
+	cv::Matx33d M = camera.P.get_minor<3, 3>(0, 0);
+	if (std::abs(cv::determinant(M)) < 1e-12) return camera;
+
+	camera.invM = M.inv();
+	camera.center = -(camera.invM * cv::Vec3d(camera.P(0, 3), camera.P(1, 3), camera.P(2, 3)));
+	camera.valid = true;
+	return camera;
+}
+
+taurus::tracking::TriangulationCamera taurus::tracking::createTriangulationCamera(const cv::Mat& P, const cv::Mat& T, const UndistortionGrid& grid) {
+	if (grid.IsBuilt() && !T.empty()) return createTriangulationCamera(T, grid.GetFocalLength());
+	return createTriangulationCamera(P);
+}
+
+taurus::tracking::ViewObservation taurus::tracking::createViewObservation(int camera, const TrackedObject::PerCameraData& data, const UndistortionGrid& grid, int64_t referenceUs) {
+	cv::Point2f center = alignedCenter(data, referenceUs);
+
+	ViewObservation view;
+	view.camera = camera;
+	view.point = grid.IsBuilt() ? grid.Lookup(center) : center;
+	view.weight = observationWeight(data.circleRadius);
+	return view;
+}
+
+float taurus::tracking::observationWeight(float circleRadius) {
+	// the center error of a fitted circle falls with the square root of its edge length
+	return std::sqrt(std::max(circleRadius, 1.f));
+}
+
+// private helper function
+// direction of the ray through a view's pixel, normalized
+static cv::Vec3d viewRay(const std::vector<taurus::tracking::TriangulationCamera>& cameras, const taurus::tracking::ViewObservation& view) {
+	cv::Vec3d ray = cameras[view.camera].invM * cv::Vec3d(view.point.x, view.point.y, 1.0);
+	return cv::normalize(ray);
+}
+
+// private helper function
+// sine of the angle between two rays, 1 is perpendicular (best conditioned), 0 is parallel
+static double raySine(const cv::Vec3d& a, const cv::Vec3d& b) {
+	return cv::norm(a.cross(b));
+}
+
+void taurus::tracking::selectTriangulationViews(const std::vector<TriangulationCamera>& cameras, std::vector<ViewObservation>& views, size_t maxViews) {
+	if (views.size() <= maxViews || maxViews < 2) return;
+
+	thread_local std::vector<cv::Vec3d> rays;
+	thread_local std::vector<ViewObservation> selected;
+	thread_local std::vector<bool> used;
+
+	rays.clear();
+	for (const ViewObservation& view : views) {
+		rays.push_back(viewRay(cameras, view));
+	}
+
+	// the best conditioned pair first
+	size_t bestA = 0;
+	size_t bestB = 1;
+	double bestSine = -1.0;
+	for (size_t a = 0; a < views.size(); a++) {
+		for (size_t b = a + 1; b < views.size(); b++) {
+			double sine = raySine(rays[a], rays[b]);
+			if (sine > bestSine) {
+				bestSine = sine;
+				bestA = a;
+				bestB = b;
+			}
+		}
+	}
+
+	selected.clear();
+	selected.push_back(views[bestA]);
+	selected.push_back(views[bestB]);
+	used.assign(views.size(), false);
+	used[bestA] = true;
+	used[bestB] = true;
+
+	// then the views whose ray is furthest from every ray already picked
+	while (selected.size() < maxViews) {
+		size_t bestView = 0;
+		double bestMinSine = -1.0;
+		for (size_t v = 0; v < views.size(); v++) {
+			if (used[v]) continue;
+
+			double minSine = 1.0;
+			for (size_t s = 0; s < views.size(); s++) {
+				if (used[s]) minSine = std::min(minSine, raySine(rays[v], rays[s]));
+			}
+			if (minSine > bestMinSine) {
+				bestMinSine = minSine;
+				bestView = v;
+			}
+		}
+
+		used[bestView] = true;
+		selected.push_back(views[bestView]);
+	}
+
+	views = selected;
+}
+
+void taurus::tracking::TriangulationPoint::SetViews(const std::vector<ViewObservation>& views) {
+	viewCount = std::min(views.size(), MAX_TRIANGULATION_VIEWS);
+	std::copy(views.begin(), views.begin() + viewCount, this->views.begin());
+}
+
+// private helper function
+// projective depth of a point in one camera, the distance along its optical axis for a P = K * [R|t]
+static inline double viewDepth(const cv::Matx34d& P, const cv::Vec3d& X) {
+	return P(2, 0) * X[0] + P(2, 1) * X[1] + P(2, 2) * X[2] + P(2, 3);
+}
+
+// private helper function
+// least squares solution of the views' DLT rows, every row scaled by its view's scale
+// the homogeneous coordinate is fixed to 1 (tracked points are never at infinity), which leaves 3x3 normal equations instead of an SVD
+// accumulated in double, the normal equations square the condition number of narrow baselines
+static bool solveWeightedDlt(const std::vector<taurus::tracking::TriangulationCamera>& cameras, const taurus::tracking::TriangulationPoint& point, const double* scales, cv::Vec3d& X) {
+	cv::Matx33d normal = cv::Matx33d::zeros();
+	cv::Vec3d rhs = cv::Vec3d(0.0, 0.0, 0.0);
+
+	for (size_t i = 0; i < point.viewCount; i++) {
+		const cv::Matx34d& P = cameras[point.views[i].camera].P;
+		double scale2 = scales[i] * scales[i];
+
+		// x * P3 - P1 and y * P3 - P2
+		for (int r = 0; r < 2; r++) {
+			double p = r == 0 ? point.views[i].point.x : point.views[i].point.y;
+			double a[4];
+			for (int c = 0; c < 4; c++) {
+				a[c] = p * P(2, c) - P(r, c);
+			}
+
+			for (int j = 0; j < 3; j++) {
+				for (int k = 0; k < 3; k++) {
+					normal(j, k) += scale2 * a[j] * a[k];
+				}
+				rhs[j] -= scale2 * a[j] * a[3];
+			}
+		}
+	}
+
+	// (nearly) parallel rays leave the depth along them undetermined
+	double trace = normal(0, 0) + normal(1, 1) + normal(2, 2);
+	if (!(trace > 0.0) || cv::determinant(normal) <= 1e-12 * trace * trace * trace) return false;
+
+	X = normal.solve(rhs, cv::DECOMP_CHOLESKY);
+	return true;
+}
+
+bool taurus::tracking::triangulatePoint(const std::vector<TriangulationCamera>& cameras, TriangulationPoint& point) {
+	point.valid = false;
+	point.residual = 0.f;
+	if (point.viewCount < 2) return false;
+
+	// the weights are per pixel, normalized coordinates are scaled back to pixels
+	double weights[MAX_TRIANGULATION_VIEWS];
+	double scales[MAX_TRIANGULATION_VIEWS];
+	for (size_t i = 0; i < point.viewCount; i++) {
+		weights[i] = point.views[i].weight * cameras[point.views[i].camera].pixelScale;
+		scales[i] = weights[i];
+	}
+
+	// the plain DLT minimizes an algebraic error that grows with the distance to each camera
+	// dividing every view's rows by its depth from the first solution turns that into (close to) the pixel error
+	cv::Vec3d X;
+	for (int pass = 0; pass < 2; pass++) {
+		if (!solveWeightedDlt(cameras, point, scales, X)) return false;
+
+		for (size_t i = 0; i < point.viewCount; i++) {
+			double depth = viewDepth(cameras[point.views[i].camera].P, X);
+
+			// a point behind any of the cameras is a bad match, not a position
+			if (depth <= 0.0) return false;
+			scales[i] = weights[i] / depth;
+		}
+	}
+
+	double squaredError = 0.0;
+	for (size_t i = 0; i < point.viewCount; i++) {
+		const TriangulationCamera& camera = cameras[point.views[i].camera];
+		const cv::Matx34d& P = camera.P;
+		double depth = viewDepth(P, X);
+		double u = (P(0, 0) * X[0] + P(0, 1) * X[1] + P(0, 2) * X[2] + P(0, 3)) / depth;
+		double v = (P(1, 0) * X[0] + P(1, 1) * X[1] + P(1, 2) * X[2] + P(1, 3)) / depth;
+
+		double du = u - point.views[i].point.x;
+		double dv = v - point.views[i].point.y;
+		squaredError += (du * du + dv * dv) * camera.pixelScale * camera.pixelScale;
+	}
+
+	point.position = cv::Point3f(static_cast<float>(X[0]), static_cast<float>(X[1]), static_cast<float>(X[2]));
+	point.residual = static_cast<float>(std::sqrt(squaredError / static_cast<double>(point.viewCount)));
+	point.valid = true;
+	return true;
+}
+
+void taurus::tracking::triangulateBatch(const std::vector<TriangulationCamera>& cameras, std::vector<TriangulationPoint>& points) {
+	for (TriangulationPoint& point : points) {
+		triangulatePoint(cameras, point);
+	}
+}
+
+bool taurus::tracking::estimateMonocularPosition(const TriangulationCamera& camera, const ViewObservation& view, float radius, cv::Point3f& position, float& uncertainty) {
+	if (!camera.valid || radius < MIN_MONOCULAR_RADIUS) return false;
+
+	// the angle the ball's radius covers, from the rays through its center and its edge
+	double edgeOffset = radius / camera.pixelScale;
+	cv::Vec3d centerRay = camera.invM * cv::Vec3d(view.point.x, view.point.y, 1.0);
+	cv::Vec3d edgeRay = camera.invM * cv::Vec3d(view.point.x + edgeOffset, view.point.y, 1.0);
+	double angle = std::atan2(cv::norm(centerRay.cross(edgeRay)), centerRay.dot(edgeRay));
+	if (!(angle > 0.0)) return false;
+
+	// a sphere's outline is where the rays touch it, so the center is radius / sin(angle) away
+	double distance = BALL_RADIUS_CM / std::sin(angle);
+	cv::Vec3d center = camera.center + cv::normalize(centerRay) * distance;
+	position = cv::Point3f(static_cast<float>(center[0]), static_cast<float>(center[1]), static_cast<float>(center[2]));
+
+	float radiusError = MONOCULAR_RADIUS_ERROR_PX + MONOCULAR_RADIUS_ERROR_FRACTION * radius;
+	uncertainty = static_cast<float>(distance * radiusError / radius);
+	return true;
+}
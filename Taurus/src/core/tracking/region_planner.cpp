@@ -0,0 +1,61 @@
+#include "core/tracking/region_planner.h"
+
+#include "core/tracking/tracking_utils.h"
+
+// private helper function
+// two regions are worth merging if their bounding union is not bigger than processing both of them separately
+static bool shouldMerge(const cv::Rect& a, const cv::Rect& b) {
+	if ((a & b).area() <= 0) return false;
+
+	cv::Rect merged = a | b;
+	return merged.area() <= a.area() + b.area();
+}
+
+void taurus::tracking::planRegions(const cv::Mat& frame, const std::vector<cv::Rect>& rois, bool wholeFrame, std::vector<SegmentRegion>& regions) {
+	regions.clear();
+	cv::Rect frameRoi = createFrameRoi(frame);
+
+	if (wholeFrame) {
+		SegmentRegion& region = regions.emplace_back();
+		region.bounds = frameRoi;
+		for (size_t i = 0; i < rois.size(); i++) {
+			region.members.push_back(i);
+		}
+		return;
+	}
+
+	// start with one region per roi
+	for (size_t i = 0; i < rois.size(); i++) {
+		SegmentRegion& region = regions.emplace_back();
+		region.bounds = rois[i] & frameRoi;
+		region.members.push_back(i);
+	}
+
+	// merge until nothing changes, a merged region can grow into another one
+	bool merged = true;
+	while (merged) {
+		merged = false;
+
+		for (size_t a = 0; a < regions.size() && !merged; a++) {
+			for (size_t b = a + 1; b < regions.size(); b++) {
+				if (!shouldMerge(regions[a].bounds, regions[b].bounds)) continue;
+
+				regions[a].bounds |= regions[b].bounds;
+				regions[a].members.insert(regions[a].members.end(), regions[b].members.begin(), regions[b].members.end());
+				regions.erase(regions.begin() + b);
+
+				merged = true;
+				break;
+			}
+		}
+	}
+}
+
+size_t taurus::tracking::regionPixelCount(const std::vector<SegmentRegion>& regions) {
+	size_t count = 0;
+	for (const SegmentRegion& region : regions) {
+		count += static_cast<size_t>(region.bounds.area());
+	}
+
+	return count;
+}
@@ -0,0 +1,58 @@
+#include "core/tracking/roi_prediction.h"
+
+#include "core/utils.h"
+
+// extra pixels around the predicted ball, for the glow and the detector's opening
+static constexpr int ROI_MARGIN_PX = 8;
+// smallest predicted roi half size, very distant balls still get a usable roi
+static constexpr int MIN_ROI_HALF_SIZE = 16;
+// anything closer than this is treated as behind the camera
+static constexpr float MIN_DEPTH = 1.f;
+
+taurus::tracking::CameraProjection taurus::tracking::createCameraProjection(const cv::Mat& P, const cv::Mat& K, const cv::Mat& originWorld, const cv::Size& frameSize) {
+	CameraProjection projection;
+	if (P.empty() || K.empty() || originWorld.empty()) return projection;
+
+	cv::Mat worldToImage = P * originWorld.inv();
+	for (int r = 0; r < 3; r++) {
+		for (int c = 0; c < 4; c++) {
+			projection.worldToImage(r, c) = worldToImage.at<double>(r, c);
+		}
+	}
+
+	projection.focalLength = K.at<double>(0, 0);
+	projection.frameSize = frameSize;
+	projection.valid = true;
+	return projection;
+}
+
+bool taurus::tracking::projectWorldPoint(const CameraProjection& projection, const glm::vec3& worldPosition, cv::Point2f& imagePoint, float& depth) {
+	if (!projection.valid) return false;
+
+	cv::Vec3d projected = projection.worldToImage * cv::Vec4d(worldPosition.x, worldPosition.y, worldPosition.z, 1.0);
+
+	// the last row of K is [0 0 1], so w is the depth in the camera
+	depth = static_cast<float>(projected[2]);
+	if (depth < MIN_DEPTH) return false;
+
+	imagePoint = cv::Point2f(static_cast<float>(projected[0] / projected[2]), static_cast<float>(projected[1] / projected[2]));
+	return true;
+}
+
+bool taurus::tracking::predictRoi(const CameraProjection& projection, const glm::vec3& worldPosition, float positionUncertainty, cv::Rect& roi) {
+	cv::Point2f center;
+	float depth;
+	if (!projectWorldPoint(projection, worldPosition, center, depth)) return false;
+
+	// the ball and everywhere it could be, at this depth
+	float worldHalfSize = BALL_RADIUS_CM + positionUncertainty;
+	int halfSize = roundToInt(static_cast<float>(projection.focalLength) * worldHalfSize / depth) + ROI_MARGIN_PX;
+	halfSize = std::max(halfSize, MIN_ROI_HALF_SIZE);
+
+	cv::Rect predicted = cv::Rect(roundToInt(center.x) - halfSize, roundToInt(center.y) - halfSize, halfSize * 2, halfSize * 2);
+	predicted &= cv::Rect(cv::Point(0, 0), projection.frameSize);
+	if (predicted.area() <= 0) return false;
+
+	roi = predicted;
+	return true;
+}
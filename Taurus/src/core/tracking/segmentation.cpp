@@ -0,0 +1,483 @@
+#include "core/tracking/segmentation.h"
+#include "core/tracking/color_lut.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TAURUS_SEGMENT_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TAURUS_SEGMENT_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TAURUS_SEGMENT_NEON
+#endif
+
+static constexpr uchar BRIGHT_BIT = taurus::tracking::CLASS_BRIGHT_BIT;
+
+// thin wrapper over the float vector type of the target instruction set
+// comparisons return lane masks stored in the same type, which are only combined with maskAnd/select/maskBits
+namespace
+{
+#if defined(TAURUS_SEGMENT_AVX2)
+	constexpr int LANES = 8;
+	struct VecF { __m256 v; };
+
+	inline VecF load(const float* p) { return { _mm256_load_ps(p) }; }
+	inline VecF splat(float x) { return { _mm256_set1_ps(x) }; }
+	inline VecF operator+(VecF a, VecF b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline VecF operator-(VecF a, VecF b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline VecF operator*(VecF a, VecF b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline VecF div(VecF a, VecF b) { return { _mm256_div_ps(a.v, b.v) }; }
+	inline VecF vmax(VecF a, VecF b) { return { _mm256_max_ps(a.v, b.v) }; }
+	inline VecF vmin(VecF a, VecF b) { return { _mm256_min_ps(a.v, b.v) }; }
+	inline VecF cmpEq(VecF a, VecF b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+	inline VecF cmpGt(VecF a, VecF b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+	inline VecF cmpGe(VecF a, VecF b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+	inline VecF cmpLe(VecF a, VecF b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+	inline VecF cmpLt(VecF a, VecF b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+	inline VecF maskAnd(VecF a, VecF b) { return { _mm256_and_ps(a.v, b.v) }; }
+	inline VecF select(VecF m, VecF a, VecF b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+	inline int maskBits(VecF m) { return _mm256_movemask_ps(m.v); }
+#elif defined(TAURUS_SEGMENT_SSE)
+	constexpr int LANES = 4;
+	struct VecF { __m128 v; };
+
+	inline VecF load(const float* p) { return { _mm_load_ps(p) }; }
+	inline VecF splat(float x) { return { _mm_set1_ps(x) }; }
+	inline VecF operator+(VecF a, VecF b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline VecF operator-(VecF a, VecF b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline VecF operator*(VecF a, VecF b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline VecF div(VecF a, VecF b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline VecF vmax(VecF a, VecF b) { return { _mm_max_ps(a.v, b.v) }; }
+	inline VecF vmin(VecF a, VecF b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline VecF cmpEq(VecF a, VecF b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+	inline VecF cmpGt(VecF a, VecF b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+	inline VecF cmpGe(VecF a, VecF b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+	inline VecF cmpLe(VecF a, VecF b) { return { _mm_cmple_ps(a.v, b.v) }; }
+	inline VecF cmpLt(VecF a, VecF b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+	inline VecF maskAnd(VecF a, VecF b) { return { _mm_and_ps(a.v, b.v) }; }
+	inline VecF select(VecF m, VecF a, VecF b) { return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) }; }
+	inline int maskBits(VecF m) { return _mm_movemask_ps(m.v); }
+#elif defined(TAURUS_SEGMENT_NEON)
+	constexpr int LANES = 4;
+	struct VecF { float32x4_t v; };
+
+	inline VecF fromMask(uint32x4_t m) { return { vreinterpretq_f32_u32(m) }; }
+	inline uint32x4_t toMask(VecF a) { return vreinterpretq_u32_f32(a.v); }
+
+	inline VecF load(const float* p) { return { vld1q_f32(p) }; }
+	inline VecF splat(float x) { return { vdupq_n_f32(x) }; }
+	inline VecF operator+(VecF a, VecF b) { return { vaddq_f32(a.v, b.v) }; }
+	inline VecF operator-(VecF a, VecF b) { return { vsubq_f32(a.v, b.v) }; }
+	inline VecF operator*(VecF a, VecF b) { return { vmulq_f32(a.v, b.v) }; }
+#if defined(__aarch64__) || defined(_M_ARM64)
+	inline VecF div(VecF a, VecF b) { return { vdivq_f32(a.v, b.v) }; }
+#else
+	inline VecF div(VecF a, VecF b) {
+		// armv7 has no vector divide, refine the reciprocal estimate twice
+		float32x4_t r = vrecpeq_f32(b.v);
+		r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+		r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+		return { vmulq_f32(a.v, r) };
+	}
+#endif
+	inline VecF vmax(VecF a, VecF b) { return { vmaxq_f32(a.v, b.v) }; }
+	inline VecF vmin(VecF a, VecF b) { return { vminq_f32(a.v, b.v) }; }
+	inline VecF cmpEq(VecF a, VecF b) { return fromMask(vceqq_f32(a.v, b.v)); }
+	inline VecF cmpGt(VecF a, VecF b) { return fromMask(vcgtq_f32(a.v, b.v)); }
+	inline VecF cmpGe(VecF a, VecF b) { return fromMask(vcgeq_f32(a.v, b.v)); }
+	inline VecF cmpLe(VecF a, VecF b) { return fromMask(vcleq_f32(a.v, b.v)); }
+	inline VecF cmpLt(VecF a, VecF b) { return fromMask(vcltq_f32(a.v, b.v)); }
+	inline VecF maskAnd(VecF a, VecF b) { return fromMask(vandq_u32(toMask(a), toMask(b))); }
+	inline VecF select(VecF m, VecF a, VecF b) { return { vbslq_f32(toMask(m), a.v, b.v) }; }
+	inline int maskBits(VecF m) {
+		uint32x4_t bits = vshrq_n_u32(toMask(m), 31);
+		return static_cast<int>(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) | (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+	}
+#else
+	// scalar fallback, masks are 1.f or 0.f
+	constexpr int LANES = 1;
+	struct VecF { float v; };
+
+	inline VecF load(const float* p) { return { *p }; }
+	inline VecF splat(float x) { return { x }; }
+	inline VecF operator+(VecF a, VecF b) { return { a.v + b.v }; }
+	inline VecF operator-(VecF a, VecF b) { return { a.v - b.v }; }
+	inline VecF operator*(VecF a, VecF b) { return { a.v * b.v }; }
+	inline VecF div(VecF a, VecF b) { return { a.v / b.v }; }
+	inline VecF vmax(VecF a, VecF b) { return { std::max(a.v, b.v) }; }
+	inline VecF vmin(VecF a, VecF b) { return { std::min(a.v, b.v) }; }
+	inline VecF cmpEq(VecF a, VecF b) { return { a.v == b.v ? 1.f : 0.f }; }
+	inline VecF cmpGt(VecF a, VecF b) { return { a.v > b.v ? 1.f : 0.f }; }
+	inline VecF cmpGe(VecF a, VecF b) { return { a.v >= b.v ? 1.f : 0.f }; }
+	inline VecF cmpLe(VecF a, VecF b) { return { a.v <= b.v ? 1.f : 0.f }; }
+	inline VecF cmpLt(VecF a, VecF b) { return { a.v < b.v ? 1.f : 0.f }; }
+	inline VecF maskAnd(VecF a, VecF b) { return { a.v * b.v }; }
+	inline VecF select(VecF m, VecF a, VecF b) { return m.v != 0.f ? a : b; }
+	inline int maskBits(VecF m) { return m.v != 0.f ? 1 : 0; }
+#endif
+
+	// byte i of entry n is 1 if bit i of n is set, used to spread lane masks into bytes
+	constexpr std::array<uint64_t, 256> SPREAD_BITS_TABLE = [] {
+		std::array<uint64_t, 256> table = {};
+		for (int i = 0; i < 256; i++) {
+			for (int bit = 0; bit < 8; bit++) {
+				if (i & (1 << bit)) table[i] |= uint64_t(1) << (bit * 8);
+			}
+		}
+		return table;
+	}();
+
+	inline uint64_t spreadBits(int laneBits) {
+		return SPREAD_BITS_TABLE[laneBits & 0xFF];
+	}
+
+	struct ColorBounds {
+		float lower[3];
+		float upper[3];
+	};
+
+	// classifies LANES pixels given as planar floats
+	// the hsv math follows cv::cvtColor(COLOR_BGR2HSV) for 8-bit images (H in [0, 180), S and V in [0, 255])
+	inline void classifyLanes(const float* b, const float* g, const float* r, const ColorBounds* bounds, int colorCount, float brightThreshold, uchar* out) {
+		VecF vb = load(b);
+		VecF vg = load(g);
+		VecF vr = load(r);
+
+		// brightness gate, same weights as BGR2GRAY
+		VecF gray = vb * splat(0.114f) + vg * splat(0.587f) + vr * splat(0.299f);
+		int brightBits = maskBits(cmpGt(gray, splat(brightThreshold)));
+
+		// most of a dark exposure frame is background, and the opening never turns on a pixel that wasn't bright
+		// so the color of dark pixels doesn't matter, skip the hsv math for them
+		if (brightBits == 0) {
+			std::memset(out, 0, LANES);
+			return;
+		}
+
+		// saturation and value
+		VecF v = vmax(vmax(vb, vg), vr);
+		VecF diff = v - vmin(vmin(vb, vg), vr);
+		VecF s = div(diff * splat(255.f), vmax(v, splat(1.f)));
+
+		// hue, picked by which channel holds the max
+		VecF scale = div(splat(60.f), vmax(diff, splat(1.f)));
+		VecF hR = (vg - vb) * scale;
+		VecF hG = splat(120.f) + (vb - vr) * scale;
+		VecF hB = splat(240.f) + (vr - vg) * scale;
+		VecF h = select(cmpEq(v, vr), hR, select(cmpEq(v, vg), hG, hB));
+		h = select(cmpLt(h, splat(0.f)), h + splat(360.f), h) * splat(0.5f);
+
+		int colorBits[taurus::tracking::MAX_SEGMENT_COLORS];
+		for (int k = 0; k < colorCount; k++) {
+			const ColorBounds& c = bounds[k];
+			VecF m = maskAnd(cmpGe(h, splat(c.lower[0])), cmpLe(h, splat(c.upper[0])));
+			m = maskAnd(m, maskAnd(cmpGe(s, splat(c.lower[1])), cmpLe(s, splat(c.upper[1]))));
+			m = maskAnd(m, maskAnd(cmpGe(v, splat(c.lower[2])), cmpLe(v, splat(c.upper[2]))));
+			colorBits[k] = maskBits(m);
+		}
+
+		// spread the lane bits into bytes, 8 lanes at a time
+		uint64_t bits = spreadBits(brightBits) << 7;
+		for (int k = 0; k < colorCount; k++) {
+			bits |= spreadBits(colorBits[k]) << k;
+		}
+		std::memcpy(out, &bits, LANES);
+	}
+}
+
+// classifies LANES (or fewer, at the end of a row) BGR pixels
+static inline void classifyChunk(const uchar* px, int n, const ColorBounds* bounds, int colorCount, float brightThreshold, uchar* out) {
+	alignas(32) float b[LANES];
+	alignas(32) float g[LANES];
+	alignas(32) float r[LANES];
+	uchar laneBits[LANES];
+
+	for (int i = 0; i < n; i++) {
+		b[i] = static_cast<float>(px[i * 3 + 0]);
+		g[i] = static_cast<float>(px[i * 3 + 1]);
+		r[i] = static_cast<float>(px[i * 3 + 2]);
+	}
+	for (int i = n; i < LANES; i++) {
+		b[i] = g[i] = r[i] = 0.f;
+	}
+
+	classifyLanes(b, g, r, bounds, colorCount, brightThreshold, laneBits);
+	std::copy(laneBits, laneBits + n, out);
+}
+
+// classifies a single row of BGR pixels into class bits, reading every pixel once
+static void classifyRow(const uchar* bgr, int width, const ColorBounds* bounds, int colorCount, float brightThreshold, uchar* out) {
+	// gray can never be above the brightest channel, so dark groups of pixels can skip the float conversion entirely
+	// the group check is a fixed size byte max, which the compiler vectorizes
+	constexpr int GROUP = 16;
+	int x = 0;
+	for (; x + GROUP <= width; x += GROUP) {
+		const uchar* px = bgr + x * 3;
+
+		uchar brightest = 0;
+		for (int i = 0; i < GROUP * 3; i++) {
+			brightest = std::max(brightest, px[i]);
+		}
+		if (brightest < brightThreshold) {
+			std::memset(out + x, 0, GROUP);
+			continue;
+		}
+
+		for (int i = 0; i < GROUP; i += LANES) {
+			classifyChunk(px + i * 3, LANES, bounds, colorCount, brightThreshold, out + x + i);
+		}
+	}
+
+	// leftover pixels at the end of the row
+	for (; x < width; x += LANES) {
+		classifyChunk(bgr + x * 3, std::min(LANES, width - x), bounds, colorCount, brightThreshold, out + x);
+	}
+}
+
+// 3x3 min (erode) of the bright bit, rows are given as [above, current, below], edges are replicated
+// tmp is a scratch row, the loops are kept branch free so the compiler can vectorize them
+static void erodeBrightRow(const uchar* above, const uchar* row, const uchar* below, int width, uchar* tmp, uchar* out) {
+	for (int x = 0; x < width; x++) {
+		tmp[x] = above[x] & row[x] & below[x] & BRIGHT_BIT;
+	}
+
+	int last = width - 1;
+	out[0] = tmp[0] & tmp[std::min(1, last)];
+	for (int x = 1; x < last; x++) {
+		out[x] = tmp[x - 1] & tmp[x] & tmp[x + 1];
+	}
+	if (last > 0) out[last] = tmp[last - 1] & tmp[last];
+}
+
+// 3x3 max (dilate) of already eroded rows, edges are replicated
+static void dilateBrightRow(const uchar* above, const uchar* row, const uchar* below, int width, uchar* tmp, uchar* out) {
+	for (int x = 0; x < width; x++) {
+		tmp[x] = above[x] | row[x] | below[x];
+	}
+
+	int last = width - 1;
+	out[0] = tmp[0] | tmp[std::min(1, last)];
+	for (int x = 1; x < last; x++) {
+		out[x] = tmp[x - 1] | tmp[x] | tmp[x + 1];
+	}
+	if (last > 0) out[last] = tmp[last - 1] | tmp[last];
+}
+
+// private helper function
+static void makeColorBounds(const std::vector<taurus::tracking::HsvColorRange>& colors, ColorBounds* bounds) {
+	for (size_t k = 0; k < colors.size(); k++) {
+		for (int c = 0; c < 3; c++) {
+			bounds[k].lower[c] = static_cast<float>(colors[k].lower[c]);
+			bounds[k].upper[c] = static_cast<float>(colors[k].upper[c]);
+		}
+	}
+}
+
+// private helper function
+// runs the classification (classifyPixels(bgr, width, out)) and the opening over the roi, and hands every finished row to writeRow(y, openedRow, classRow)
+// the opened row only has the bright bit (0x80) set, the class row has the raw color bits
+template<typename RowClassifier, typename RowWriter>
+static void openClassifiedRoi(const cv::Mat& frame, const cv::Rect& roi, RowClassifier&& classifyPixels, RowWriter&& writeRow) {
+	int width = roi.width;
+	int height = roi.height;
+	if (width < 1 || height < 1) return;
+
+	// the opening needs the classified rows y-2..y+2 and the eroded rows y-1..y+1, so keep small ring buffers of both
+	// this way every BGR pixel is read exactly once and the rest stays in cache
+	constexpr int CLASS_RING = 5;
+	constexpr int ERODED_RING = 3;
+	thread_local std::vector<uchar> scratch;
+	scratch.resize(static_cast<size_t>(width) * (CLASS_RING + ERODED_RING + 2));
+
+	uchar* classRows[CLASS_RING];
+	uchar* erodedRows[ERODED_RING];
+	int classRowIndex[CLASS_RING];
+	int erodedRowIndex[ERODED_RING];
+	for (int i = 0; i < CLASS_RING; i++) {
+		classRows[i] = scratch.data() + static_cast<size_t>(width) * i;
+		classRowIndex[i] = -1;
+	}
+	for (int i = 0; i < ERODED_RING; i++) {
+		erodedRows[i] = scratch.data() + static_cast<size_t>(width) * (CLASS_RING + i);
+		erodedRowIndex[i] = -1;
+	}
+	uchar* openedRow = scratch.data() + static_cast<size_t>(width) * (CLASS_RING + ERODED_RING);
+	uchar* tmpRow = scratch.data() + static_cast<size_t>(width) * (CLASS_RING + ERODED_RING + 1);
+
+	auto clampRow = [height](int y) {
+		return std::clamp(y, 0, height - 1);
+	};
+	auto getClassRow = [&](int y) {
+		y = clampRow(y);
+		int slot = y % CLASS_RING;
+		if (classRowIndex[slot] != y) {
+			classifyPixels(frame.ptr<uchar>(roi.y + y) + roi.x * 3, width, classRows[slot]);
+			classRowIndex[slot] = y;
+		}
+		return classRows[slot];
+	};
+	auto getErodedRow = [&](int y) {
+		y = clampRow(y);
+		int slot = y % ERODED_RING;
+		if (erodedRowIndex[slot] != y) {
+			erodeBrightRow(getClassRow(y - 1), getClassRow(y), getClassRow(y + 1), width, tmpRow, erodedRows[slot]);
+			erodedRowIndex[slot] = y;
+		}
+		return erodedRows[slot];
+	};
+
+	for (int y = 0; y < height; y++) {
+		// erode the rows below first, so the ring never evicts a row that's still needed
+		const uchar* erodedBelow = getErodedRow(y + 1);
+		const uchar* erodedRow = getErodedRow(y);
+		const uchar* erodedAbove = getErodedRow(y - 1);
+		dilateBrightRow(erodedAbove, erodedRow, erodedBelow, width, tmpRow, openedRow);
+
+		writeRow(y, openedRow, getClassRow(y));
+	}
+}
+
+// writes the opened class rows of classifyRoi, pixels removed by the opening lose their color bits as well
+struct ClassRowWriter {
+	cv::Mat& classes;
+
+	void operator()(int y, const uchar* openedRow, const uchar* classRow) const {
+		int width = classes.cols;
+		uchar* outRow = classes.ptr<uchar>(y);
+		for (int x = 0; x < width; x++) {
+			uchar keep = static_cast<uchar>(0 - (openedRow[x] >> 7));
+			outRow[x] = static_cast<uchar>((classRow[x] | BRIGHT_BIT) & keep);
+		}
+	}
+};
+
+void taurus::tracking::segmentRoi(const cv::Mat& frame, const cv::Rect& roi, const std::vector<HsvColorRange>& colors, std::vector<cv::Mat>& masks, int brightThreshold) {
+	CV_Assert(frame.type() == CV_8UC3);
+	CV_Assert(colors.size() <= MAX_SEGMENT_COLORS);
+
+	int width = roi.width;
+	int colorCount = static_cast<int>(colors.size());
+
+	masks.resize(colors.size());
+	for (cv::Mat& mask : masks) {
+		mask.create(roi.height, width, CV_8UC1);
+	}
+	if (colorCount < 1) return;
+
+	ColorBounds bounds[MAX_SEGMENT_COLORS];
+	makeColorBounds(colors, bounds);
+	float threshold = static_cast<float>(brightThreshold);
+	auto classifyPixels = [&](const uchar* bgr, int rowWidth, uchar* out) {
+		classifyRow(bgr, rowWidth, bounds, colorCount, threshold, out);
+	};
+
+	openClassifiedRoi(frame, roi, classifyPixels, [&](int y, const uchar* openedRow, const uchar* classRow) {
+		for (int k = 0; k < colorCount; k++) {
+			uchar* maskRow = masks[k].ptr<uchar>(y);
+			for (int x = 0; x < width; x++) {
+				maskRow[x] = static_cast<uchar>(((openedRow[x] >> 7) & (classRow[x] >> k) & 1) * 255);
+			}
+		}
+	});
+}
+
+void taurus::tracking::classifyRoi(const cv::Mat& frame, const cv::Rect& roi, const std::vector<HsvColorRange>& colors, cv::Mat& classes, int brightThreshold) {
+	CV_Assert(frame.type() == CV_8UC3);
+	CV_Assert(colors.size() <= MAX_SEGMENT_COLORS);
+
+	int colorCount = static_cast<int>(colors.size());
+	classes.create(roi.height, roi.width, CV_8UC1);
+
+	ColorBounds bounds[MAX_SEGMENT_COLORS];
+	makeColorBounds(colors, bounds);
+	float threshold = static_cast<float>(brightThreshold);
+	auto classifyPixels = [&](const uchar* bgr, int rowWidth, uchar* out) {
+		classifyRow(bgr, rowWidth, bounds, colorCount, threshold, out);
+	};
+
+	openClassifiedRoi(frame, roi, classifyPixels, ClassRowWriter{ classes });
+}
+
+void taurus::tracking::classifyRoi(const cv::Mat& frame, const cv::Rect& roi, const ColorLut& colorLut, cv::Mat& classes, int brightThreshold) {
+	CV_Assert(frame.type() == CV_8UC3);
+	CV_Assert(colorLut.IsBuilt());
+
+	classes.create(roi.height, roi.width, CV_8UC1);
+
+	// one table fetch per pixel, no hsv conversion at all
+	const uchar* table = colorLut.Data();
+	if (brightThreshold <= colorLut.GetBrightThreshold()) {
+		auto classifyPixels = [table](const uchar* bgr, int rowWidth, uchar* out) {
+			for (int x = 0; x < rowWidth; x++) {
+				out[x] = table[ColorLut::Index(bgr[x * 3 + 0], bgr[x * 3 + 1], bgr[x * 3 + 2])];
+			}
+		};
+
+		openClassifiedRoi(frame, roi, classifyPixels, ClassRowWriter{ classes });
+		return;
+	}
+
+	// the table's gate is lower than the requested one, gray (BGR2GRAY weights in 8 bit fixed point) gates the fetched bits
+	auto classifyGatedPixels = [table, brightThreshold](const uchar* bgr, int rowWidth, uchar* out) {
+		for (int x = 0; x < rowWidth; x++) {
+			const uchar* px = bgr + x * 3;
+			int gray = (px[0] * 29 + px[1] * 150 + px[2] * 77) >> 8;
+			uchar keep = static_cast<uchar>(0 - static_cast<int>(gray > brightThreshold));
+			out[x] = table[ColorLut::Index(px[0], px[1], px[2])] & keep;
+		}
+	};
+
+	openClassifiedRoi(frame, roi, classifyGatedPixels, ClassRowWriter{ classes });
+}
+
+void taurus::tracking::classifyRoiUnopened(const cv::Mat& frame, const cv::Rect& roi, const std::vector<HsvColorRange>& colors, cv::Mat& classes, int brightThreshold) {
+	CV_Assert(frame.type() == CV_8UC3);
+	CV_Assert(colors.size() <= MAX_SEGMENT_COLORS);
+
+	int width = roi.width;
+	int colorCount = static_cast<int>(colors.size());
+	classes.create(roi.height, width, CV_8UC1);
+
+	ColorBounds bounds[MAX_SEGMENT_COLORS];
+	makeColorBounds(colors, bounds);
+	float threshold = static_cast<float>(brightThreshold);
+
+	// no ring buffers needed, every row is classified straight into the output and only dark pixels lose their color bits
+	for (int y = 0; y < roi.height; y++) {
+		uchar* outRow = classes.ptr<uchar>(y);
+		classifyRow(frame.ptr<uchar>(roi.y + y) + roi.x * 3, width, bounds, colorCount, threshold, outRow);
+
+		for (int x = 0; x < width; x++) {
+			uchar keep = static_cast<uchar>(0 - (outRow[x] >> 7));
+			outRow[x] &= keep;
+		}
+	}
+}
+
+void taurus::tracking::segmentRoi(const cv::Mat& frame, const cv::Rect& roi, const HsvColorRange& color, cv::Mat& mask, int brightThreshold) {
+	thread_local std::vector<HsvColorRange> colors(1);
+	thread_local std::vector<cv::Mat> masks(1);
+
+	colors[0] = color;
+	masks[0] = mask;
+	segmentRoi(frame, roi, colors, masks, brightThreshold);
+	mask = masks[0];
+}
+
+const char* taurus::tracking::segmentationKernelName() {
+#if defined(TAURUS_SEGMENT_AVX2)
+	return "AVX2";
+#elif defined(TAURUS_SEGMENT_SSE)
+	return "SSE2";
+#elif defined(TAURUS_SEGMENT_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,94 @@
+#include "core/tracking/static_lights.h"
+
+#include "core/tracking/brightness.h"
+
+// a pixel is a static light while it's bright in more than this fraction of the frames, and stops being one below the lower fraction
+static constexpr float STATIC_ON_FRACTION = 0.8f;
+static constexpr float STATIC_OFF_FRACTION = 0.5f;
+// weight of a tracking frame in the running fraction, updates come every STATIC_LIGHT_UPDATE_INTERVAL frames so lights fade in and out over seconds
+static constexpr double STATIC_UPDATE_RATE = 0.05;
+// pixels around a static light that are skipped too, its glow and the demosaic blur
+static constexpr int STATIC_LIGHT_MARGIN = 3;
+
+void taurus::tracking::StaticLightMask::Reset(const cv::Size& frameSize) {
+	brightFraction = cv::Mat::zeros(frameSize, CV_32F);
+	staticCore = cv::Mat::zeros(frameSize, CV_8UC1);
+	mask = cv::Mat::zeros(frameSize, CV_8UC1);
+	learnedFrames = 0;
+	ready = false;
+}
+
+void taurus::tracking::StaticLightMask::FindBright(const cv::Mat& frame) {
+	// the lowest gate the adaptive thresholds go to, anything that could become a blob counts
+	if (frame.type() == CV_8UC1) {
+		cv::threshold(frame, bright, MIN_BRIGHT_THRESHOLD - 1, 255, cv::THRESH_BINARY);
+	}
+	else {
+		cv::cvtColor(frame, bright, cv::COLOR_BGR2GRAY);
+		cv::threshold(bright, bright, MIN_BRIGHT_THRESHOLD - 1, 255, cv::THRESH_BINARY);
+	}
+}
+
+void taurus::tracking::StaticLightMask::Learn(const cv::Mat& frame) {
+	if (frame.size() != brightFraction.size()) Reset(frame.size());
+
+	FindBright(frame);
+	cv::accumulate(bright, brightFraction);
+	learnedFrames++;
+}
+
+void taurus::tracking::StaticLightMask::FinishLearning() {
+	// no frame arrived while learning, there is nothing to build the mask from and the camera is tracked without one
+	if (learnedFrames == 0) return;
+
+	// the sums of 255s into fractions
+	brightFraction.convertTo(brightFraction, CV_32F, 1.0 / (255.0 * learnedFrames));
+
+	RebuildMask();
+	ready = true;
+}
+
+void taurus::tracking::StaticLightMask::Update(const cv::Mat& frame, const std::vector<cv::Rect>& excluded) {
+	if (!ready || frame.size() != brightFraction.size()) return;
+
+	FindBright(frame);
+	bright.convertTo(bright, CV_8UC1, 1.0 / 255.0);
+
+	// the fraction is tracked in 0..1, the excluded rects keep theirs
+	thread_local cv::Mat updateMask;
+	updateMask.create(frame.size(), CV_8UC1);
+	updateMask.setTo(cv::Scalar::all(255));
+	for (const cv::Rect& rect : excluded) {
+		cv::Rect area = rect & cv::Rect(0, 0, frame.cols, frame.rows);
+		if (!area.empty()) updateMask(area).setTo(cv::Scalar::all(0));
+	}
+	cv::accumulateWeighted(bright, brightFraction, STATIC_UPDATE_RATE, updateMask);
+
+	RebuildMask();
+}
+
+void taurus::tracking::StaticLightMask::RebuildMask() {
+	thread_local cv::Mat on;
+	thread_local cv::Mat stay;
+
+	// lights turn on above the upper fraction, and only turn off again below the lower one
+	cv::compare(brightFraction, STATIC_ON_FRACTION, on, cv::CMP_GT);
+	cv::compare(brightFraction, STATIC_OFF_FRACTION, stay, cv::CMP_GT);
+	cv::bitwise_and(stay, staticCore, stay);
+	cv::bitwise_or(on, stay, staticCore);
+
+	cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(STATIC_LIGHT_MARGIN * 2 + 1, STATIC_LIGHT_MARGIN * 2 + 1));
+	cv::dilate(staticCore, mask, kernel);
+}
+
+bool taurus::tracking::StaticLightMask::IsReady() const {
+	return ready;
+}
+
+const cv::Mat& taurus::tracking::StaticLightMask::GetMask() const {
+	return mask;
+}
+
+int taurus::tracking::StaticLightMask::GetSuppressedPixels() const {
+	return mask.empty() ? 0 : cv::countNonZero(mask);
+}
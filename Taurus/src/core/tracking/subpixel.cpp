@@ -0,0 +1,176 @@
+#include "core/tracking/subpixel.h"
+
+#include <algorithm>
+#include <cmath>
+
+// the intensity window is grown by this much around the blob, so the anti-aliased edge and some of the glow are included
+static constexpr int INTENSITY_WINDOW_MARGIN = 2;
+
+// private helper function
+// brightness weighted centroid, the weight is how far the brightest channel is above the threshold
+static bool intensityCentroid(const cv::Mat& frame, const cv::Rect& blobBounds, int brightThreshold, cv::Point2f& center) {
+	cv::Rect window = blobBounds;
+	taurus::tracking::increaseRoiSize(window, INTENSITY_WINDOW_MARGIN * 2);
+	window &= taurus::tracking::createFrameRoi(frame);
+
+	double sumWeight = 0.0;
+	double sumX = 0.0;
+	double sumY = 0.0;
+	for (int y = window.y; y < window.y + window.height; y++) {
+		const uchar* row = frame.ptr<uchar>(y);
+
+		double rowWeight = 0.0;
+		double rowX = 0.0;
+		for (int x = window.x; x < window.x + window.width; x++) {
+			int brightest = std::max({ row[x * 3 + 0], row[x * 3 + 1], row[x * 3 + 2] });
+			int weight = std::max(brightest - brightThreshold, 0);
+
+			rowWeight += weight;
+			rowX += static_cast<double>(weight) * x;
+		}
+
+		sumWeight += rowWeight;
+		sumX += rowX;
+		sumY += rowWeight * y;
+	}
+
+	if (sumWeight <= 0.0) return false;
+
+	center = cv::Point2f(static_cast<float>(sumX / sumWeight), static_cast<float>(sumY / sumWeight));
+	return true;
+}
+
+// private helper function
+static inline int brightestChannel(const cv::Mat& frame, int x, int y) {
+	const uchar* px = frame.ptr<uchar>(y) + x * 3;
+	return std::max({ px[0], px[1], px[2] });
+}
+
+// private helper function
+// algebraic (Kasa) circle fit on the edge pixels of the blob
+// every edge pixel is moved along the radial direction by its coverage (brightness relative to the blob's core), which gives subpixel edge points
+// edge pixels that touch the border of the class image are skipped, that edge is the roi/frame border and not the ball
+static bool circleFit(const cv::Mat& frame, const cv::Mat& classes, const cv::Point& classesOffset, const taurus::tracking::BlobStats& blob, cv::Point2f& center, float& radius) {
+	const cv::Rect& bounds = blob.bounds;
+	auto isBright = [&](int x, int y) {
+		return (classes.ptr<uchar>(y)[x] & taurus::tracking::CLASS_BRIGHT_BIT) != 0;
+	};
+
+	// brightness of a fully covered pixel
+	int core = 0;
+	for (int y = bounds.y; y < bounds.y + bounds.height; y++) {
+		for (int x = bounds.x; x < bounds.x + bounds.width; x++) {
+			if (isBright(x, y)) core = std::max(core, brightestChannel(frame, x + classesOffset.x, y + classesOffset.y));
+		}
+	}
+	if (core <= 0) return false;
+
+	// fit in coordinates relative to the blob centroid, keeps the normal equations well conditioned
+	double originX = blob.centroid.x;
+	double originY = blob.centroid.y;
+
+	// sums for the normal equations of x^2 + y^2 + D*x + E*y + F = 0
+	double sxx = 0.0, sxy = 0.0, syy = 0.0, sx = 0.0, sy = 0.0;
+	double sxz = 0.0, syz = 0.0, sz = 0.0;
+	int count = 0;
+
+	int lastX = classes.cols - 1;
+	int lastY = classes.rows - 1;
+	for (int y = bounds.y; y < bounds.y + bounds.height; y++) {
+		for (int x = bounds.x; x < bounds.x + bounds.width; x++) {
+			if (!isBright(x, y)) continue;
+			if (x == 0 || y == 0 || x == lastX || y == lastY) continue;
+
+			bool isEdge = !isBright(x - 1, y) || !isBright(x + 1, y) || !isBright(x, y - 1) || !isBright(x, y + 1);
+			if (!isEdge) continue;
+
+			double px = x - originX;
+			double py = y - originY;
+			double length = std::sqrt(px * px + py * py);
+			if (length < 1e-6) continue;
+
+			// a pixel with coverage c has its center (c - 0.5) pixels inside the edge
+			double coverage = std::min(static_cast<double>(brightestChannel(frame, x + classesOffset.x, y + classesOffset.y)) / core, 1.0);
+			double shift = (coverage - 0.5) / length;
+			px += px * shift;
+			py += py * shift;
+			double z = px * px + py * py;
+
+			sxx += px * px;
+			sxy += px * py;
+			syy += py * py;
+			sx += px;
+			sy += py;
+			sxz += px * z;
+			syz += py * z;
+			sz += z;
+			count++;
+		}
+	}
+
+	if (count < 3) return false;
+
+	cv::Matx33d A = cv::Matx33d(
+		sxx, sxy, sx,
+		sxy, syy, sy,
+		sx, sy, static_cast<double>(count)
+	);
+	cv::Vec3d b = cv::Vec3d(-sxz, -syz, -sz);
+
+	cv::Vec3d solution;
+	if (!cv::solve(A, b, solution, cv::DECOMP_CHOLESKY)) return false;
+
+	double cx = -solution[0] / 2.0;
+	double cy = -solution[1] / 2.0;
+	double r2 = cx * cx + cy * cy - solution[2];
+	if (r2 <= 0.0) return false;
+
+	center = cv::Point2f(static_cast<float>(cx + originX), static_cast<float>(cy + originY));
+	radius = static_cast<float>(std::sqrt(r2));
+	return true;
+}
+
+bool taurus::tracking::estimateBallCenter(const cv::Mat& frame, const cv::Mat& classes, const cv::Point& classesOffset, const BlobStats& blob, CenterEstimator estimator, cv::Point2f& center, float& radius, int brightThreshold) {
+	cv::Point2f offset = cv::Point2f(static_cast<float>(classesOffset.x), static_cast<float>(classesOffset.y));
+
+	// blob centroid, also the fallback of the other estimators
+	center = blob.centroid + offset;
+	radius = static_cast<float>(std::max(blob.bounds.width, blob.bounds.height)) / 2.f;
+
+	switch (estimator) {
+		case Center_BLOB_CENTROID:
+			return true;
+		case Center_INTENSITY_CENTROID:
+			return intensityCentroid(frame, blob.bounds + classesOffset, brightThreshold, center);
+		case Center_CIRCLE_FIT: {
+			cv::Point2f fitCenter;
+			float fitRadius;
+			if (!circleFit(frame, classes, classesOffset, blob, fitCenter, fitRadius)) return false;
+
+			center = fitCenter + offset;
+			radius = fitRadius;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool taurus::tracking::centerEstimatorFromName(const std::string& name, CenterEstimator& estimator) {
+	if (name == "blob") estimator = Center_BLOB_CENTROID;
+	else if (name == "intensity") estimator = Center_INTENSITY_CENTROID;
+	else if (name == "circle_fit") estimator = Center_CIRCLE_FIT;
+	else return false;
+
+	return true;
+}
+
+const char* taurus::tracking::centerEstimatorName(CenterEstimator estimator) {
+	switch (estimator) {
+		case Center_BLOB_CENTROID: return "blob";
+		case Center_INTENSITY_CENTROID: return "intensity";
+		case Center_CIRCLE_FIT: return "circle_fit";
+	}
+
+	return "unknown";
+}
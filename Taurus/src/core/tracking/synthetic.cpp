@@ -0,0 +1,62 @@
+#include "core/tracking/synthetic.h"
+
+#include <algorithm>
+#include <cmath>
+
+void taurus::tracking::renderDarkBackground(cv::Mat& frame, cv::RNG& rng, double mean, double stddev) {
+	rng.fill(frame, cv::RNG::NORMAL, cv::Scalar::all(mean), cv::Scalar::all(stddev));
+}
+
+void taurus::tracking::renderGlowingBall(cv::Mat& frame, const cv::Point2f& center, float radius, const cv::Scalar& color, float glow) {
+	CV_Assert(frame.type() == CV_8UC3);
+
+	// the glow falls off quickly, so only render a bit past the edge of the ball
+	float glowFalloff = std::max(radius * 0.35f, 0.5f);
+	float extent = radius + glowFalloff * 4.f + 1.f;
+
+	int x0 = std::max(static_cast<int>(std::floor(center.x - extent)), 0);
+	int y0 = std::max(static_cast<int>(std::floor(center.y - extent)), 0);
+	int x1 = std::min(static_cast<int>(std::ceil(center.x + extent)), frame.cols - 1);
+	int y1 = std::min(static_cast<int>(std::ceil(center.y + extent)), frame.rows - 1);
+
+	for (int y = y0; y <= y1; y++) {
+		cv::Vec3b* row = frame.ptr<cv::Vec3b>(y);
+		for (int x = x0; x <= x1; x++) {
+			// pixel centers are at integer coordinates, same as what the contour/moment functions assume
+			float dx = static_cast<float>(x) - center.x;
+			float dy = static_cast<float>(y) - center.y;
+			float d = std::sqrt(dx * dx + dy * dy);
+
+			// anti-aliased coverage of the ball, with a bit of limb darkening inside
+			float coverage = std::clamp(radius - d + 0.5f, 0.f, 1.f);
+			float limb = 1.f - 0.15f * std::min(d * d / (radius * radius), 1.f);
+			float halo = glow * std::exp(-std::max(d - radius, 0.f) / glowFalloff);
+			float intensity = std::max(coverage * limb, halo);
+			if (intensity <= 0.f) continue;
+
+			for (int c = 0; c < 3; c++) {
+				row[x][c] = cv::saturate_cast<uchar>(row[x][c] + color[c] * intensity);
+			}
+		}
+	}
+}
+
+void taurus::tracking::renderStaticLight(cv::Mat& frame, const cv::Rect& rect, double brightness) {
+	cv::Rect clipped = rect & cv::Rect(0, 0, frame.cols, frame.rows);
+	frame(clipped).setTo(cv::Scalar(brightness * 0.85, brightness * 0.95, brightness));
+}
+
+taurus::tracking::HsvColorRange taurus::tracking::hsvRangeFromBgr(const cv::Scalar& color) {
+	cv::Mat pixel = cv::Mat(1, 1, CV_8UC3, color);
+	cv::Mat hsv;
+	cv::cvtColor(pixel, hsv, cv::COLOR_BGR2HSV);
+
+	cv::Vec3b hsvPixel = hsv.at<cv::Vec3b>(0, 0);
+	cv::Scalar avg = cv::Scalar(hsvPixel[0], hsvPixel[1], hsvPixel[2]);
+
+	// same bounds as the color calibrator
+	HsvColorRange range;
+	range.lower = avg - cv::Scalar(30, 40, 45);
+	range.upper = avg + cv::Scalar(30, 40, 45);
+	return range;
+}
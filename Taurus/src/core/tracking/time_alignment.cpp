@@ -0,0 +1,45 @@
+#include "core/tracking/time_alignment.h"
+
+#include <algorithm>
+
+// how much of a new velocity measurement is taken, the center noise of two detections is amplified by the frame rate
+static constexpr float IMAGE_VELOCITY_SMOOTHING = 0.6f;
+
+int64_t taurus::tracking::rowTimestampUs(int64_t frameTimestampUs, const RowTiming& timing, float row) {
+	if (timing.rowReadoutNs <= 0 || timing.rows <= 0) return frameTimestampUs;
+
+	float rowsBefore = std::clamp(static_cast<float>(timing.rows - 1) - row, 0.f, static_cast<float>(timing.rows - 1));
+	return frameTimestampUs - static_cast<int64_t>(rowsBefore * static_cast<float>(timing.rowReadoutNs) / 1000.f);
+}
+
+void taurus::tracking::updateImageMotion(TrackedObject::PerCameraData& data, int64_t timestampUs) {
+	TrackedObject::ImageMotion& motion = data.motion;
+	if (!data.acquiredTracking) {
+		motion = {};
+		return;
+	}
+
+	// no new frame from this camera, the detection is the one already recorded
+	int64_t gapUs = timestampUs - motion.previousTimestampUs;
+	if (motion.previousTimestampUs != 0 && gapUs == 0) return;
+
+	data.timestampUs = timestampUs;
+	if (motion.previousTimestampUs != 0 && gapUs > 0 && gapUs <= MAX_IMAGE_VELOCITY_GAP_US) {
+		cv::Point2f velocity = (data.globalCircleCenter - motion.previousCenter) * (1000000.f / static_cast<float>(gapUs));
+		motion.velocity = motion.hasVelocity ? motion.velocity + (velocity - motion.velocity) * IMAGE_VELOCITY_SMOOTHING : velocity;
+		motion.hasVelocity = true;
+	}
+	else {
+		motion.hasVelocity = false;
+	}
+
+	motion.previousCenter = data.globalCircleCenter;
+	motion.previousTimestampUs = timestampUs;
+}
+
+cv::Point2f taurus::tracking::alignedCenter(const TrackedObject::PerCameraData& data, int64_t referenceUs) {
+	if (!data.motion.hasVelocity) return data.globalCircleCenter;
+
+	int64_t offsetUs = std::clamp(referenceUs - data.timestampUs, -MAX_TIME_ALIGNMENT_US, MAX_TIME_ALIGNMENT_US);
+	return data.globalCircleCenter + data.motion.velocity * (static_cast<float>(offsetUs) / 1000000.f);
+}
@@ -101,33 +101,6 @@ void taurus::tracking::drawEpilines(cv::Mat& frame, std::vector<cv::Point3f>& li
 	}
 }
 
-cv::Point2f taurus::tracking::undistort(const cv::Point2f& point, const cv::Mat& K, const cv::Mat& distort) {
-	static std::vector<cv::Point2f> points = { point };
-	static std::vector<cv::Point2f> undistorted;
-
-	cv::undistortPoints(points, undistorted, K, distort);
-	return undistorted[0];
-}
-
-cv::Point3f taurus::tracking::triangulate(const cv::Mat& P0, const cv::Mat& P1, TrackedObject::PerCameraData& cam0Data, TrackedObject::PerCameraData& cam1Data) {
-	static cv::Mat points0 = cv::Mat(2, 1, CV_64FC1);
-	static cv::Mat points1 = cv::Mat(2, 1, CV_64FC1);
-
-	points0.at<double>(0, 0) = static_cast<double>(cam0Data.globalCircleCenter.x);
-	points0.at<double>(1, 0) = static_cast<double>(cam0Data.globalCircleCenter.y);
-	points1.at<double>(0, 0) = static_cast<double>(cam1Data.globalCircleCenter.x);
-	points1.at<double>(1, 0) = static_cast<double>(cam1Data.globalCircleCenter.y);
-
-	static cv::Mat homogeneous = cv::Mat(4, 1, CV_64FC1);
-	cv::triangulatePoints(P0, P1, points0, points1, homogeneous);
-
-	double w = homogeneous.at<double>(3, 0);
-	float x = static_cast<float>(homogeneous.at<double>(0, 0) / w);
-	float y = static_cast<float>(homogeneous.at<double>(1, 0) / w);
-	float z = static_cast<float>(homogeneous.at<double>(2, 0) / w);
-	return cv::Point3f(x, y, z);
-}
-
 cv::Point3f taurus::tracking::transform(const cv::Mat& mat4x4, const cv::Point3f& point) {
 	// multiply
 	static cv::Mat hom = cv::Mat(4, 1, CV_64FC1);
@@ -0,0 +1,44 @@
+#include "core/tracking/undistortion.h"
+
+#include <cmath>
+
+void taurus::tracking::UndistortionGrid::Build(const cv::Mat& K, const cv::Mat& distort, const cv::Size& frameSize, int step) {
+	Clear();
+	if (K.empty() || frameSize.empty() || step <= 0) return;
+
+	columns = frameSize.width / step + 2;
+	rows = frameSize.height / step + 2;
+	inverseStep = 1.f / static_cast<float>(step);
+
+	std::vector<cv::Point2f> pixels;
+	pixels.reserve(static_cast<size_t>(columns) * rows);
+	for (int y = 0; y < rows; y++) {
+		for (int x = 0; x < columns; x++) {
+			pixels.push_back(cv::Point2f(static_cast<float>(x * step), static_cast<float>(y * step)));
+		}
+	}
+
+	// it only runs once, so the iterative solve can afford to converge properly, even in the strongly distorted corners
+	cv::TermCriteria criteria = cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 50, 1e-9);
+	cv::undistortPoints(pixels, nodes, K, distort, cv::noArray(), cv::noArray(), criteria);
+
+	cv::Mat K64;
+	K.convertTo(K64, CV_64F);
+	focalLength = std::sqrt(K64.at<double>(0, 0) * K64.at<double>(1, 1));
+}
+
+void taurus::tracking::UndistortionGrid::Clear() {
+	nodes.clear();
+	columns = 0;
+	rows = 0;
+	inverseStep = 0.f;
+	focalLength = 1.0;
+}
+
+bool taurus::tracking::UndistortionGrid::IsBuilt() const {
+	return !nodes.empty();
+}
+
+double taurus::tracking::UndistortionGrid::GetFocalLength() const {
+	return focalLength;
+}